@@ -4,4 +4,5 @@
 #include "Modules/ModuleManager.h"
 
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, IlluviumTask, "IlluviumTask" );
-DEFINE_LOG_CATEGORY(LogTask);
\ No newline at end of file
+DEFINE_LOG_CATEGORY(LogTask);
+DEFINE_LOG_CATEGORY(LogTaskPathfinding);
\ No newline at end of file
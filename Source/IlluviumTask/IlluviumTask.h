@@ -4,4 +4,5 @@
 
 #include "CoreMinimal.h"
 
-DECLARE_LOG_CATEGORY_EXTERN(LogTask, Log, All);
\ No newline at end of file
+DECLARE_LOG_CATEGORY_EXTERN(LogTask, Log, All);
+DECLARE_LOG_CATEGORY_EXTERN(LogTaskPathfinding, Log, All);
\ No newline at end of file
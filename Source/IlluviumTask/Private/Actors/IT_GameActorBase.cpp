@@ -6,8 +6,8 @@
 // Sets default values
 AIT_GameActorBase::AIT_GameActorBase()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+ 	// The actor only visualizes a simulation unit and is moved by the game mode, it doesn't need to tick.
+	PrimaryActorTick.bCanEverTick = false;
 	
 	USceneComponent* SceneComponent = CreateDefaultSubobject<USceneComponent>("Root");
 	RootComponent = SceneComponent;
@@ -28,10 +28,9 @@ void AIT_GameActorBase::StartDestroy()
 	Destroy();
 }
 
-void AIT_GameActorBase::MoveActorInterp(const FVector& InNewLocation, float InInterpTime_ms)
+void AIT_GameActorBase::MoveActorInterp(const FVector& InFromLocation, const FVector& InToLocation, float InAlpha)
 {
-	// TODO: make it lerp here..
-	//SetActorLocation(FMath::Lerp(GetActorLocation(), InNewLocation, InInterpTime_ms));
+	SetActorLocation(FMath::Lerp(InFromLocation, InToLocation, InAlpha));
 }
 
 void AIT_GameActorBase::SetTeam(ETeam InTeam)
@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Actors/IT_UnitInstancedRenderer.h"
+
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Grid/IT_Grid.h"
+#include "UObject/ConstructorHelpers.h"
+#include "Simulation/IT_UnitStore.h"
+
+AIT_UnitInstancedRenderer::AIT_UnitInstancedRenderer()
+{
+	// The instances are updated by the game mode every frame, see UpdateInstances
+	PrimaryActorTick.bCanEverTick = false;
+
+	USceneComponent* SceneComponent = CreateDefaultSubobject<USceneComponent>("Root");
+	RootComponent = SceneComponent;
+
+	auto CreateInstancesComponent = [this](const FName& InName)
+	{
+		auto* Instances = CreateDefaultSubobject<UInstancedStaticMeshComponent>(InName);
+		Instances->SetupAttachment(RootComponent);
+		Instances->SetMobility(EComponentMobility::Movable);
+		Instances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		Instances->SetGenerateOverlapEvents(false);
+		return Instances;
+	};
+	RedTeamInstances = CreateInstancesComponent(TEXT("RedTeamInstances"));
+	BlueTeamInstances = CreateInstancesComponent(TEXT("BlueTeamInstances"));
+
+	// A placeholder, to be overridden in the blueprint
+	static ConstructorHelpers::FObjectFinder<UStaticMesh> DefaultMesh(TEXT("/Engine/BasicShapes/Cube.Cube"));
+	UnitMesh = DefaultMesh.Object;
+}
+
+void AIT_UnitInstancedRenderer::AddUnits(const FUnitStore& InUnits, float InGridCellSize, EGridType InGridType)
+{
+	GridCellSize = InGridCellSize;
+	GridType = InGridType;
+
+	RedTeamInstances->SetStaticMesh(UnitMesh);
+	RedTeamInstances->SetMaterial(0, RedTeamMaterial);
+	BlueTeamInstances->SetStaticMesh(UnitMesh);
+	BlueTeamInstances->SetMaterial(0, BlueTeamMaterial);
+
+	for (UInstancedStaticMeshComponent* Instances : {RedTeamInstances.Get(), BlueTeamInstances.Get()})
+	{
+		FTeamInstances& Team = TeamInstances.FindOrAdd(Instances);
+		const int32 FirstNewInstance = Team.UnitIds.Num();
+
+		for (int32 UnitId = NumRegisteredUnits; UnitId < InUnits.Num(); ++UnitId)
+		{
+			if (GetTeamInstances(InUnits.Teams[UnitId]) == Instances)
+			{
+				Team.UnitIds.Add(UnitId);
+				Team.Transforms.Add(GetUnitTransform(InUnits, UnitId, 1.f));
+			}
+		}
+
+		if (Team.Transforms.Num() > FirstNewInstance)
+		{
+			Instances->AddInstances(TArray<FTransform>(Team.Transforms.GetData() + FirstNewInstance,
+			                                           Team.Transforms.Num() - FirstNewInstance), false, true);
+		}
+	}
+
+	NumRegisteredUnits = InUnits.Num();
+}
+
+void AIT_UnitInstancedRenderer::UpdateInstances(const FUnitStore& InUnits, float InAlpha)
+{
+	for (auto& InstancesTeam : TeamInstances)
+	{
+		FTeamInstances& Team = InstancesTeam.Value;
+		bool bChanged = false;
+		for (int32 InstanceIndex = 0; InstanceIndex < Team.UnitIds.Num(); ++InstanceIndex)
+		{
+			const FTransform Transform = GetUnitTransform(InUnits, Team.UnitIds[InstanceIndex], InAlpha);
+			if (Transform.Equals(Team.Transforms[InstanceIndex], 0.f))
+			{
+				continue;
+			}
+
+			// The units move between the neighbor points, so they aren't teleported and keep their motion vectors
+			Team.Transforms[InstanceIndex] = Transform;
+			InstancesTeam.Key->UpdateInstanceTransform(InstanceIndex, Transform, true, false, false);
+			bChanged = true;
+		}
+
+		if (bChanged)
+		{
+			InstancesTeam.Key->MarkRenderStateDirty();
+		}
+	}
+}
+
+UInstancedStaticMeshComponent* AIT_UnitInstancedRenderer::GetTeamInstances(ETeam InTeam) const
+{
+	return InTeam == ETeam::BlueTeam ? BlueTeamInstances : RedTeamInstances;
+}
+
+FTransform AIT_UnitInstancedRenderer::GetUnitTransform(const FUnitStore& InUnits, int32 InUnitId, float InAlpha) const
+{
+	const FVector2D Position = FMath::Lerp(FGrid::GetLayoutPosition(GridType, InUnits.PreviousPositions[InUnitId]),
+	                                       FGrid::GetLayoutPosition(GridType, InUnits.Positions[InUnitId]), InAlpha);
+	const FVector Location{Position.X * GridCellSize, Position.Y * GridCellSize, 0.f};
+	return FTransform(FQuat::Identity, Location, InUnits.IsAlive(InUnitId) ? FVector::OneVector : FVector::ZeroVector);
+}
@@ -0,0 +1,454 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Commandlets/IT_BenchmarkCommandlet.h"
+
+#include "Dom/JsonObject.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameModes/IT_GameModeDefault.h"
+#include "Grid/IT_Grid.h"
+#include "Grid/IT_HierarchicalPathfinder.h"
+#include "Grid/IT_Pathfinder.h"
+#include "IlluviumTask/IlluviumTask.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Simulation/IT_SimulationRandom.h"
+
+// Any unit id marks a point as an obstacle for the pathfinding cases
+static constexpr int32 ObstacleUnitId = 0;
+
+// Keeps the optimizer from dropping the results of the timed code
+static volatile int64 BenchmarkSink = 0;
+
+// A plain load and store, the compound assignments to a volatile are deprecated in C++20
+static void SinkResult(int64 InResult)
+{
+	BenchmarkSink = BenchmarkSink + InResult;
+}
+
+// The side of a square grid that is about a quarter full with the units
+static int32 GetGridSizeForUnits(int32 InNumUnits)
+{
+	return FMath::Max(64, FMath::CeilToInt(FMath::Sqrt(InNumUnits * 4.f)));
+}
+
+double UIT_BenchmarkCommandlet::FCaseResult::GetPercentileMs(double InPercentile) const
+{
+	if (Samples.IsEmpty())
+	{
+		return 0.0;
+	}
+
+	TArray<double> SortedSamples = Samples;
+	SortedSamples.Sort();
+	const int32 Rank = FMath::Clamp(FMath::CeilToInt(InPercentile * SortedSamples.Num()), 1, SortedSamples.Num());
+	return SortedSamples[Rank - 1] * 1000.0;
+}
+
+double UIT_BenchmarkCommandlet::FCaseResult::GetMeanMs() const
+{
+	if (Samples.IsEmpty())
+	{
+		return 0.0;
+	}
+
+	double Total = 0.0;
+	for (const double Sample : Samples)
+	{
+		Total += Sample;
+	}
+	return Total / Samples.Num() * 1000.0;
+}
+
+UIT_BenchmarkCommandlet::UIT_BenchmarkCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UIT_BenchmarkCommandlet::Main(const FString& Params)
+{
+	FBenchmarkSettings Settings;
+	FString JsonPath;
+	FString BaselinePath;
+	double Threshold = 0.1;
+
+	FParse::Value(*Params, TEXT("Seed="), Settings.Seed);
+	FParse::Value(*Params, TEXT("Iterations="), Settings.Iterations);
+	FParse::Value(*Params, TEXT("MaxGridSize="), Settings.MaxGridSize);
+	FParse::Value(*Params, TEXT("MaxUnits="), Settings.MaxUnits);
+	FParse::Value(*Params, TEXT("Json="), JsonPath);
+	FParse::Value(*Params, TEXT("Baseline="), BaselinePath);
+	FParse::Value(*Params, TEXT("Threshold="), Threshold);
+	Settings.Iterations = FMath::Max(Settings.Iterations, 1);
+
+	TArray<FCaseResult> Results;
+	RunGridCases(Settings, Results);
+	RunPathCases(Settings, Results);
+	RunClosestActorCases(Settings, Results);
+	RunTurnCases(Settings, Results);
+
+	TArray<TSharedPtr<FJsonValue>> CaseValues;
+	for (const FCaseResult& Result : Results)
+	{
+		UE_LOG(LogTask, Display, TEXT("[IT_Benchmark] %s: median %.4f ms, p99 %.4f ms, %d samples, %lld bytes"),
+		       *Result.Name, Result.GetPercentileMs(0.5), Result.GetPercentileMs(0.99), Result.Samples.Num(),
+		       Result.MemoryBytes);
+
+		const TSharedRef<FJsonObject> CaseObject = MakeShared<FJsonObject>();
+		CaseObject->SetStringField(TEXT("Name"), Result.Name);
+		CaseObject->SetNumberField(TEXT("Samples"), Result.Samples.Num());
+		CaseObject->SetNumberField(TEXT("MedianMs"), Result.GetPercentileMs(0.5));
+		CaseObject->SetNumberField(TEXT("P99Ms"), Result.GetPercentileMs(0.99));
+		CaseObject->SetNumberField(TEXT("MinMs"), Result.GetPercentileMs(0.0));
+		CaseObject->SetNumberField(TEXT("MeanMs"), Result.GetMeanMs());
+		CaseObject->SetNumberField(TEXT("MemoryBytes"), StaticCast<double>(Result.MemoryBytes));
+		CaseValues.Add(MakeShared<FJsonValueObject>(CaseObject));
+	}
+
+	if (!JsonPath.IsEmpty())
+	{
+		const TSharedRef<FJsonObject> ReportObject = MakeShared<FJsonObject>();
+		ReportObject->SetNumberField(TEXT("Seed"), Settings.Seed);
+		ReportObject->SetNumberField(TEXT("Iterations"), Settings.Iterations);
+		ReportObject->SetArrayField(TEXT("Cases"), CaseValues);
+
+		FString ReportString;
+		const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&ReportString);
+		if (!FJsonSerializer::Serialize(ReportObject, Writer)
+			|| !FFileHelper::SaveStringToFile(ReportString, *JsonPath))
+		{
+			UE_LOG(LogTask, Error, TEXT("[IT_Benchmark] Failed to write the report to %s."), *JsonPath);
+			return 1;
+		}
+	}
+
+	if (!BaselinePath.IsEmpty() && !CompareToBaseline(BaselinePath, Threshold, Results))
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+void UIT_BenchmarkCommandlet::RunGridCases(const FBenchmarkSettings& InSettings,
+                                           TArray<FCaseResult>& OutResults) const
+{
+	static constexpr int32 GridSizes[]{100, 256, 1024, 2048, 4096};
+	for (const int32 GridSize : GridSizes)
+	{
+		if (GridSize > InSettings.MaxGridSize)
+		{
+			break;
+		}
+
+		FCaseResult& Result = OutResults.AddDefaulted_GetRef();
+		Result.Name = FString::Printf(TEXT("GridInit_%d"), GridSize);
+		for (int32 Iteration = 0; Iteration < InSettings.Iterations; ++Iteration)
+		{
+			FGrid Grid;
+			const double StartTime = FPlatformTime::Seconds();
+			Grid.Init(GridSize, GridSize);
+			Result.Samples.Add(FPlatformTime::Seconds() - StartTime);
+			Result.MemoryBytes = Grid.GetAllocatedSize();
+		}
+	}
+
+	static constexpr int32 NeighborsGridSize = 1024;
+	static constexpr EGridType GridTypes[]{EGridType::Rectangular, EGridType::Hexagonal, EGridType::Octagonal};
+	for (const EGridType GridType : GridTypes)
+	{
+		FGrid Grid;
+		Grid.Init(NeighborsGridSize, NeighborsGridSize, GridType);
+
+		FCaseResult& Result = OutResults.AddDefaulted_GetRef();
+		Result.Name = FString::Printf(TEXT("Neighbors_%s"),
+		                              *StaticEnum<EGridType>()->GetNameStringByValue(StaticCast<int64>(GridType)));
+		Result.MemoryBytes = Grid.GetAllocatedSize();
+		for (int32 Iteration = 0; Iteration < InSettings.Iterations; ++Iteration)
+		{
+			int64 NumNeighbors = 0;
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 Index = 0; Index < Grid.Num(); ++Index)
+			{
+				Grid.ForEachNeighbor(Grid.GetCoordinates(Index), [&NumNeighbors](const FGridNeighbor& Neighbor)
+				{
+					NumNeighbors += Neighbor.Index;
+				});
+			}
+			Result.Samples.Add(FPlatformTime::Seconds() - StartTime);
+			SinkResult(NumNeighbors);
+		}
+	}
+}
+
+void UIT_BenchmarkCommandlet::RunPathCases(const FBenchmarkSettings& InSettings,
+                                           TArray<FCaseResult>& OutResults) const
+{
+	static constexpr int32 MapSize = 256;
+	static constexpr int32 NumQueries = 32;
+	static constexpr int32 CrowdedPercent = 30;
+	static constexpr int32 HierarchicalClusterSize = 16;
+
+	enum class EMap
+	{
+		Open,
+		Maze,
+		Crowded
+	};
+
+	static constexpr EMap Maps[]{EMap::Open, EMap::Maze, EMap::Crowded};
+	static constexpr EPathSearchMode SearchModes[]{EPathSearchMode::AStar, EPathSearchMode::JumpPoint};
+	for (const EMap Map : Maps)
+	{
+		FGrid Grid;
+		Grid.Init(MapSize, MapSize);
+		FSimulationRandomStream Random(InSettings.Seed, StaticCast<uint64>(Map));
+
+		const TCHAR* MapName = TEXT("Open");
+		if (Map == EMap::Maze)
+		{
+			// Walls every 4 columns, open at the bottom and the top in turns, so the paths snake across the map
+			MapName = TEXT("Maze");
+			for (int32 X = 2; X < MapSize; X += 4)
+			{
+				const int32 GapY = (X / 4) % 2 ? 0 : MapSize - 1;
+				for (int32 Y = 0; Y < MapSize; ++Y)
+				{
+					if (Y != GapY)
+					{
+						Grid.SetUnitId(FIntPoint{X, Y}, ObstacleUnitId);
+					}
+				}
+			}
+		}
+		else if (Map == EMap::Crowded)
+		{
+			MapName = TEXT("Crowded");
+			FGridPoint GridPoint;
+			for (int32 Obstacle = 0; Obstacle < Grid.Num() * CrowdedPercent / 100; ++Obstacle)
+			{
+				if (Grid.FindRandomEmptyPointOnGrid(Random, GridPoint))
+				{
+					Grid.SetUnitId(GridPoint.GridCoords, ObstacleUnitId);
+				}
+			}
+		}
+
+		TArray<Path::FQuery> Queries;
+		for (int32 Query = 0; Query < NumQueries; ++Query)
+		{
+			FGridPoint StartPoint;
+			FGridPoint GoalPoint;
+			Grid.FindRandomEmptyPointOnGrid(Random, StartPoint);
+			Grid.FindRandomEmptyPointOnGrid(Random, GoalPoint);
+			Queries.Add(Path::FQuery{StartPoint.GridCoords, GoalPoint.GridCoords});
+		}
+
+		for (const EPathSearchMode SearchMode : SearchModes)
+		{
+			IT_Pathfinder Pathfinder;
+			Pathfinder.InitGraph(Grid);
+
+			FCaseResult& Result = OutResults.AddDefaulted_GetRef();
+			Result.Name = FString::Printf(TEXT("FindPath_%s_%s"), MapName,
+			                              *StaticEnum<EPathSearchMode>()->GetNameStringByValue(
+				                              StaticCast<int64>(SearchMode)));
+			for (int32 Iteration = 0; Iteration < InSettings.Iterations; ++Iteration)
+			{
+				for (const Path::FQuery& Query : Queries)
+				{
+					const double StartTime = FPlatformTime::Seconds();
+					const TArray<Path::FNode> FoundPath = Pathfinder.FindPath(
+						Path::FNode{Query.Start, true}, Path::FNode{Query.Goal, true}, SearchMode);
+					Result.Samples.Add(FPlatformTime::Seconds() - StartTime);
+					SinkResult(FoundPath.Num());
+				}
+			}
+			Result.MemoryBytes = Grid.GetAllocatedSize() + Pathfinder.GetAllocatedSize();
+		}
+
+		// The clusters are built by the first query, it is not timed like the other samples
+		IT_HierarchicalPathfinder HierarchicalPathfinder;
+		HierarchicalPathfinder.Init(Grid, HierarchicalClusterSize);
+		SinkResult(HierarchicalPathfinder.FindPath(Path::FNode{Queries[0].Start, true},
+		                                           Path::FNode{Queries[0].Goal, true}).Num());
+
+		FCaseResult& Result = OutResults.AddDefaulted_GetRef();
+		Result.Name = FString::Printf(TEXT("FindPath_%s_Hierarchical"), MapName);
+		for (int32 Iteration = 0; Iteration < InSettings.Iterations; ++Iteration)
+		{
+			for (const Path::FQuery& Query : Queries)
+			{
+				const double StartTime = FPlatformTime::Seconds();
+				const TArray<Path::FNode> FoundPath = HierarchicalPathfinder.FindPath(
+					Path::FNode{Query.Start, true}, Path::FNode{Query.Goal, true});
+				Result.Samples.Add(FPlatformTime::Seconds() - StartTime);
+				SinkResult(FoundPath.Num());
+			}
+		}
+		Result.MemoryBytes = Grid.GetAllocatedSize() + HierarchicalPathfinder.GetAllocatedSize();
+	}
+}
+
+void UIT_BenchmarkCommandlet::RunClosestActorCases(const FBenchmarkSettings& InSettings,
+                                                   TArray<FCaseResult>& OutResults) const
+{
+	static constexpr int32 UnitCounts[]{1000, 10000, 100000};
+	static constexpr int32 LookupsPerSample = 256;
+	for (const int32 NumUnits : UnitCounts)
+	{
+		if (NumUnits > InSettings.MaxUnits)
+		{
+			break;
+		}
+
+		UWorld* World = nullptr;
+		AIT_GameModeDefault* GameMode = CreateGameWorld(GetGridSizeForUnits(NumUnits), NumUnits, InSettings.Seed,
+		                                                World);
+		if (GameMode == nullptr)
+		{
+			continue;
+		}
+
+		FCaseResult& Result = OutResults.AddDefaulted_GetRef();
+		Result.Name = FString::Printf(TEXT("FindClosestActor_%d"), NumUnits);
+		Result.MemoryBytes = GameMode->SpatialIndex.GetAllocatedSize() + GameMode->Units.GetAllocatedSize();
+
+		FSimulationRandomStream Random(InSettings.Seed, NumUnits);
+		for (int32 Iteration = 0; Iteration < InSettings.Iterations; ++Iteration)
+		{
+			int64 TargetsSum = 0;
+			const double StartTime = FPlatformTime::Seconds();
+			for (int32 Lookup = 0; Lookup < LookupsPerSample; ++Lookup)
+			{
+				int32 DistanceSqr = 0;
+				TargetsSum += GameMode->FindClosestActor(Random.RandRange(0, GameMode->Units.Num() - 1), DistanceSqr);
+			}
+			Result.Samples.Add((FPlatformTime::Seconds() - StartTime) / LookupsPerSample);
+			SinkResult(TargetsSum);
+		}
+
+		DestroyGameWorld(World);
+	}
+}
+
+void UIT_BenchmarkCommandlet::RunTurnCases(const FBenchmarkSettings& InSettings,
+                                           TArray<FCaseResult>& OutResults) const
+{
+	static constexpr int32 UnitCounts[]{1000, 10000};
+	for (const int32 NumUnits : UnitCounts)
+	{
+		if (NumUnits > InSettings.MaxUnits)
+		{
+			break;
+		}
+
+		UWorld* World = nullptr;
+		AIT_GameModeDefault* GameMode = CreateGameWorld(GetGridSizeForUnits(NumUnits), NumUnits, InSettings.Seed,
+		                                                World);
+		if (GameMode == nullptr)
+		{
+			continue;
+		}
+
+		FCaseResult& Result = OutResults.AddDefaulted_GetRef();
+		Result.Name = FString::Printf(TEXT("Turn_%d"), NumUnits);
+		for (int32 Iteration = 0; Iteration < InSettings.Iterations && GameMode->IsSimulationOngoing(); ++Iteration)
+		{
+			const double StartTime = FPlatformTime::Seconds();
+			GameMode->StepSimulation();
+			Result.Samples.Add(FPlatformTime::Seconds() - StartTime);
+		}
+		// After the turns, once the caches and the search state have grown
+		Result.MemoryBytes = GameMode->GetSimulationAllocatedSize();
+
+		DestroyGameWorld(World);
+	}
+}
+
+AIT_GameModeDefault* UIT_BenchmarkCommandlet::CreateGameWorld(int32 InGridSize, int32 InNumUnits, int32 InSeed,
+                                                              UWorld*& OutWorld) const
+{
+	OutWorld = UWorld::CreateWorld(EWorldType::Game, false, TEXT("IT_Benchmark"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(OutWorld);
+	OutWorld->InitializeActorsForPlay(FURL());
+
+	AIT_GameModeDefault* GameMode = OutWorld->SpawnActorDeferred<AIT_GameModeDefault>(
+		AIT_GameModeDefault::StaticClass(), FTransform::Identity);
+	if (GameMode == nullptr)
+	{
+		UE_LOG(LogTask, Error, TEXT("[IT_Benchmark] Failed to spawn the game mode."));
+		DestroyGameWorld(OutWorld);
+		OutWorld = nullptr;
+		return nullptr;
+	}
+
+	GameMode->SetupSimulation(InGridSize, InGridSize, InNumUnits / 2, EUnitVisualizationMode::None, InSeed);
+	GameMode->FinishSpawning(FTransform::Identity);
+	GameMode->StartHeadlessSimulation();
+	return GameMode;
+}
+
+void UIT_BenchmarkCommandlet::DestroyGameWorld(UWorld* InWorld) const
+{
+	GEngine->DestroyWorldContext(InWorld);
+	InWorld->DestroyWorld(false);
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+}
+
+bool UIT_BenchmarkCommandlet::CompareToBaseline(const FString& InBaselinePath, double InThreshold,
+                                                const TArray<FCaseResult>& InResults) const
+{
+	FString BaselineString;
+	TSharedPtr<FJsonObject> BaselineObject;
+	const TArray<TSharedPtr<FJsonValue>>* BaselineCases = nullptr;
+	if (!FFileHelper::LoadFileToString(BaselineString, *InBaselinePath)
+		|| !FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(BaselineString), BaselineObject)
+		|| !BaselineObject.IsValid() || !BaselineObject->TryGetArrayField(TEXT("Cases"), BaselineCases))
+	{
+		UE_LOG(LogTask, Error, TEXT("[IT_Benchmark] Failed to read the baseline %s."), *InBaselinePath);
+		return false;
+	}
+
+	TMap<FString, double> BaselineMedians;
+	for (const TSharedPtr<FJsonValue>& CaseValue : *BaselineCases)
+	{
+		const TSharedPtr<FJsonObject>* CaseObject = nullptr;
+		FString Name;
+		double MedianMs = 0.0;
+		if (CaseValue->TryGetObject(CaseObject) && (*CaseObject)->TryGetStringField(TEXT("Name"), Name)
+			&& (*CaseObject)->TryGetNumberField(TEXT("MedianMs"), MedianMs))
+		{
+			BaselineMedians.Add(Name, MedianMs);
+		}
+	}
+
+	int32 NumRegressions = 0;
+	for (const FCaseResult& Result : InResults)
+	{
+		const double* BaselineMedianMs = BaselineMedians.Find(Result.Name);
+		if (BaselineMedianMs == nullptr)
+		{
+			UE_LOG(LogTask, Display, TEXT("[IT_Benchmark] %s is not in the baseline."), *Result.Name);
+			continue;
+		}
+
+		const double MedianMs = Result.GetPercentileMs(0.5);
+		if (MedianMs > *BaselineMedianMs * (1.0 + InThreshold))
+		{
+			UE_LOG(LogTask, Error, TEXT("[IT_Benchmark] %s regressed: median %.4f ms, baseline %.4f ms."),
+			       *Result.Name, MedianMs, *BaselineMedianMs);
+			++NumRegressions;
+		}
+	}
+
+	UE_LOG(LogTask, Display, TEXT("[IT_Benchmark] %d regressions beyond %.0f%% against %s."), NumRegressions,
+	       InThreshold * 100.0, *InBaselinePath);
+	return NumRegressions == 0;
+}
@@ -0,0 +1,500 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Commandlets/IT_PathOracleCommandlet.h"
+
+#include "Algo/Reverse.h"
+#include "Grid/IT_Grid.h"
+#include "Grid/IT_HierarchicalPathfinder.h"
+#include "Grid/IT_PathCache.h"
+#include "Grid/IT_Pathfinder.h"
+#include "IlluviumTask/IlluviumTask.h"
+#include "Misc/FileHelper.h"
+#include "Simulation/IT_SimulationRandom.h"
+
+// Any unit id blocks a point, so the obstacles, the starts and the goals all share one
+static constexpr int32 ObstacleUnitId = 0;
+
+// The float path costs of the variants and the reference are summed in different orders
+static constexpr float CostTolerance = 1.e-3f;
+
+// Small enough for most of the grids to span several clusters
+static constexpr int32 HierarchicalClusterSize = 8;
+
+enum class EOracleVariantKind : uint8
+{
+	// IT_Pathfinder::FindPath for each query
+	Single,
+	// IT_Pathfinder::FindPaths for all the queries of the trial at once
+	Batched,
+	// IT_HierarchicalPathfinder::FindPath for each query, within its cost bound of the reference
+	Hierarchical,
+	// IT_PathCache repairing the suffix of each query's path once a point in the middle of it gets occupied
+	CacheRepair,
+};
+
+/**
+ * A way of answering the queries that is checked against the reference. The faster pathfinders are checked by adding
+ * them here.
+ */
+struct FOracleVariant
+{
+	const TCHAR* Name;
+	EOracleVariantKind Kind;
+	EPathSearchMode SearchMode;
+};
+
+static constexpr FOracleVariant OracleVariants[]{
+	{TEXT("AStar"), EOracleVariantKind::Single, EPathSearchMode::AStar},
+	{TEXT("JumpPoint"), EOracleVariantKind::Single, EPathSearchMode::JumpPoint},
+	{TEXT("Batched"), EOracleVariantKind::Batched, EPathSearchMode::AStar},
+	{TEXT("BatchedJumpPoint"), EOracleVariantKind::Batched, EPathSearchMode::JumpPoint},
+	{TEXT("Hierarchical"), EOracleVariantKind::Hierarchical, EPathSearchMode::AStar},
+	{TEXT("CacheRepair"), EOracleVariantKind::CacheRepair, EPathSearchMode::AStar},
+};
+
+static constexpr int32 NumOracleVariants = UE_ARRAY_COUNT(OracleVariants);
+
+UIT_PathOracleCommandlet::UIT_PathOracleCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UIT_PathOracleCommandlet::Main(const FString& Params)
+{
+	if (!CheckRandomStream())
+	{
+		return 1;
+	}
+
+	FOracleSettings Settings;
+	int32 Seed = 0;
+	FString CsvPath;
+
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	FParse::Value(*Params, TEXT("Trials="), Settings.Trials);
+	FParse::Value(*Params, TEXT("QueriesPerTrial="), Settings.QueriesPerTrial);
+	FParse::Value(*Params, TEXT("MinGridSize="), Settings.MinGridSize);
+	FParse::Value(*Params, TEXT("MaxGridSize="), Settings.MaxGridSize);
+	FParse::Value(*Params, TEXT("MaxDensity="), Settings.MaxDensity);
+	FParse::Value(*Params, TEXT("Csv="), CsvPath);
+	Settings.MinGridSize = FMath::Max(Settings.MinGridSize, 2);
+	Settings.MaxGridSize = FMath::Max(Settings.MaxGridSize, Settings.MinGridSize);
+
+	TArray<FString> CsvLines;
+	CsvLines.Add(TEXT("Seed,Query,Variant,StartX,StartY,GoalX,GoalY,ReferenceCost,Cost,Expansions,TimeMs,Match"));
+
+	TArray<FVariantTotals> Totals;
+	Totals.SetNum(NumOracleVariants);
+	for (int32 Trial = 0; Trial < Settings.Trials; ++Trial)
+	{
+		RunTrial(Seed + Trial, Settings, Totals, CsvLines);
+	}
+
+	int32 NumMismatches = 0;
+	for (int32 Variant = 0; Variant < Totals.Num(); ++Variant)
+	{
+		const FVariantTotals& VariantTotals = Totals[Variant];
+		const int32 NumQueries = FMath::Max(VariantTotals.Queries, 1);
+		UE_LOG(LogTask, Display,
+		       TEXT("[IT_PathOracle] %s: %d queries, %d mismatches, %.1f expansions and %.4f ms per query."),
+		       OracleVariants[Variant].Name, VariantTotals.Queries, VariantTotals.Mismatches,
+		       StaticCast<double>(VariantTotals.Expansions) / NumQueries, VariantTotals.Time * 1000.0 / NumQueries);
+		NumMismatches += VariantTotals.Mismatches;
+	}
+
+	if (!CsvPath.IsEmpty() && !FFileHelper::SaveStringArrayToFile(CsvLines, *CsvPath))
+	{
+		UE_LOG(LogTask, Error, TEXT("[IT_PathOracle] Failed to write the report to %s."), *CsvPath);
+		return 1;
+	}
+
+	return NumMismatches == 0 ? 0 : 1;
+}
+
+bool UIT_PathOracleCommandlet::CheckRandomStream()
+{
+	// The output of the PCG paper's pcg32-demo for the seed 42 and the sequence 54
+	static constexpr uint32 ReferenceValues[]{0xa15c02b7, 0x7b47f409, 0xba1d3330, 0x83d2f293, 0xbfa4784b, 0xcbed606e};
+
+	FSimulationRandomStream Random(42, 54);
+	for (int32 Value = 0; Value < UE_ARRAY_COUNT(ReferenceValues); ++Value)
+	{
+		const uint32 RandomValue = Random.Next();
+		if (RandomValue != ReferenceValues[Value])
+		{
+			UE_LOG(LogTask, Error,
+			       TEXT("[IT_PathOracle] The random stream's value %d is 0x%08x, the reference one is 0x%08x."), Value,
+			       RandomValue, ReferenceValues[Value]);
+			return false;
+		}
+	}
+	return true;
+}
+
+void UIT_PathOracleCommandlet::RunTrial(int32 InSeed, const FOracleSettings& InSettings,
+                                        TArray<FVariantTotals>& OutTotals, TArray<FString>& OutCsvLines) const
+{
+	FSimulationRandomStream Random(InSeed, 0);
+
+	// The grid
+	const int32 SizeX = Random.RandRange(InSettings.MinGridSize, InSettings.MaxGridSize);
+	const int32 SizeY = Random.RandRange(InSettings.MinGridSize, InSettings.MaxGridSize);
+	const EGridType GridType = StaticCast<EGridType>(Random.RandRange(StaticCast<int32>(EGridType::Rectangular),
+	                                                                  StaticCast<int32>(EGridType::Octagonal)));
+	const EGridCellOrdering CellOrdering = Random.RandRange(0, 1) ? EGridCellOrdering::Tiled
+		                                       : EGridCellOrdering::RowMajor;
+	const float Density = Random.FRandRange(0.f, InSettings.MaxDensity);
+
+	FGrid Grid;
+	Grid.Init(SizeX, SizeY, GridType, CellOrdering);
+
+	// Every other trial has walls and a terrain of varying costs
+	const bool bTerrain = Random.RandRange(0, 1) != 0;
+	if (bTerrain)
+	{
+		static constexpr uint8 TerrainCosts[]{FGrid::BlockedTerrainCost, 8, 16, 16, 32, 48};
+		TArray<uint8> Terrain;
+		Terrain.SetNumUninitialized(Grid.Num());
+		for (uint8& TerrainCost : Terrain)
+		{
+			TerrainCost = TerrainCosts[Random.RandRange(0, UE_ARRAY_COUNT(TerrainCosts) - 1)];
+		}
+		Grid.SetTerrain(Terrain);
+	}
+
+	FGridPoint GridPoint;
+	const int32 NumObstacles = FMath::FloorToInt(Grid.Num() * Density);
+	for (int32 Obstacle = 0; Obstacle < NumObstacles && Grid.FindRandomEmptyPointOnGrid(Random, GridPoint); ++Obstacle)
+	{
+		Grid.SetUnitId(GridPoint.GridCoords, ObstacleUnitId);
+	}
+
+	// The goals, then the queries sharing them
+	TArray<FIntPoint> Goals;
+	const int32 NumGoals = Random.RandRange(1, 4);
+	for (int32 Goal = 0; Goal < NumGoals && Grid.FindRandomEmptyPointOnGrid(Random, GridPoint); ++Goal)
+	{
+		Grid.SetUnitId(GridPoint.GridCoords, ObstacleUnitId);
+		Goals.Add(GridPoint.GridCoords);
+	}
+
+	TArray<Path::FQuery> Queries;
+	for (int32 Query = 0; Query < InSettings.QueriesPerTrial && !Goals.IsEmpty()
+	     && Grid.FindRandomEmptyPointOnGrid(Random, GridPoint); ++Query)
+	{
+		Grid.SetUnitId(GridPoint.GridCoords, ObstacleUnitId);
+		Queries.Add(Path::FQuery{GridPoint.GridCoords, Goals[Random.RandRange(0, Goals.Num() - 1)]});
+	}
+
+	TArray<float> ReferenceCosts;
+	TArray<TArray<FIntPoint>> ReferencePaths;
+	for (const Path::FQuery& Query : Queries)
+	{
+		ReferenceCosts.Add(FindReferenceCost(Grid, Query.Start, Query.Goal, ReferencePaths.AddDefaulted_GetRef()));
+	}
+
+	IT_Pathfinder Pathfinder;
+	Pathfinder.InitGraph(Grid);
+
+	TArray<TArray<Path::FNode>> Paths;
+	TArray<int32> Expansions;
+	TArray<double> Times;
+	// The range of the costs the variant may return, the reference cost for the exact ones
+	TArray<float> MinCosts;
+	TArray<float> MaxCosts;
+	// The point occupied before the query was answered, the path is checked with it occupied
+	TArray<FIntPoint> BlockedPoints;
+	TArray<FIntPoint> Points;
+	TArray<uint32> Versions;
+	for (int32 Variant = 0; Variant < NumOracleVariants; ++Variant)
+	{
+		const FOracleVariant& OracleVariant = OracleVariants[Variant];
+		Paths.Reset();
+		Expansions.Reset();
+		Times.Reset();
+		MinCosts = ReferenceCosts;
+		MaxCosts = ReferenceCosts;
+		BlockedPoints.Init(FIntPoint::NoneValue, Queries.Num());
+
+		switch (OracleVariant.Kind)
+		{
+		case EOracleVariantKind::Single:
+			for (const Path::FQuery& Query : Queries)
+			{
+				const double StartTime = FPlatformTime::Seconds();
+				Paths.Add(Pathfinder.FindPath(Path::FNode{Query.Start, true}, Path::FNode{Query.Goal, true},
+				                              OracleVariant.SearchMode));
+				Times.Add(FPlatformTime::Seconds() - StartTime);
+				Expansions.Add(Pathfinder.GetNumExpanded());
+			}
+			break;
+
+		case EOracleVariantKind::Batched:
+			{
+				// The batch is split evenly between its queries
+				const double StartTime = FPlatformTime::Seconds();
+				Paths = Pathfinder.FindPaths(Queries, OracleVariant.SearchMode);
+				const double QueryTime = (FPlatformTime::Seconds() - StartTime) / FMath::Max(Queries.Num(), 1);
+				Expansions.Init(Pathfinder.GetNumExpanded() / FMath::Max(Queries.Num(), 1), Queries.Num());
+				Times.Init(QueryTime, Queries.Num());
+			}
+			break;
+
+		case EOracleVariantKind::Hierarchical:
+			{
+				// The clusters are built by the first query, it pays for them. The expansions aren't counted
+				IT_HierarchicalPathfinder HierarchicalPathfinder;
+				HierarchicalPathfinder.Init(Grid, HierarchicalClusterSize);
+				for (int32 Query = 0; Query < Queries.Num(); ++Query)
+				{
+					const Path::FQuery& QueryData = Queries[Query];
+					const double StartTime = FPlatformTime::Seconds();
+					Paths.Add(HierarchicalPathfinder.FindPath(Path::FNode{QueryData.Start, true},
+					                                          Path::FNode{QueryData.Goal, true}));
+					Times.Add(FPlatformTime::Seconds() - StartTime);
+					Expansions.Add(0);
+
+					if (ReferenceCosts[Query] >= 0.f)
+					{
+						MaxCosts[Query] = HierarchicalPathfinder.GetCostBound(ReferencePaths[Query],
+						                                                      ReferenceCosts[Query]);
+					}
+				}
+			}
+			break;
+
+		case EOracleVariantKind::CacheRepair:
+			{
+				IT_PathCache PathCache;
+				PathCache.Init(Queries.Num(), 1);
+				auto SearchSuffix = [&](int32 InQuery, const FIntPoint& InFrom, const FIntPoint& InGoal)
+				{
+					Points.Reset();
+					Versions.Reset();
+					for (const Path::FNode& Node : Pathfinder.FindPath(Path::FNode{InFrom, true},
+					                                                   Path::FNode{InGoal, true},
+					                                                   OracleVariant.SearchMode))
+					{
+						Points.Add(Node.XY);
+						Versions.Add(Grid.GetOccupancyVersion(Grid.GetIndex(Node.XY)));
+					}
+					PathCache.ApplySuffix(InQuery, Points, Versions);
+					return !Points.IsEmpty();
+				};
+
+				TArray<FIntPoint> CachedPath;
+				for (int32 Query = 0; Query < Queries.Num(); ++Query)
+				{
+					const Path::FQuery& QueryData = Queries[Query];
+					FIntPoint NextStep;
+					FIntPoint SearchFrom;
+					PathCache.FindCachedStep(Query, QueryData.Start, QueryData.Goal, Grid, NextStep, SearchFrom);
+					SearchSuffix(Query, SearchFrom, QueryData.Goal);
+
+					// A unit steps onto the middle of the path
+					const TConstArrayView<FIntPoint> FoundPath = PathCache.GetPath(Query);
+					CachedPath.Reset();
+					CachedPath.Append(FoundPath.GetData(), FoundPath.Num());
+					if (CachedPath.Num() > 2)
+					{
+						BlockedPoints[Query] = CachedPath[CachedPath.Num() / 2];
+						Grid.SetUnitId(BlockedPoints[Query], ObstacleUnitId);
+					}
+
+					const double StartTime = FPlatformTime::Seconds();
+					PathCache.FindCachedStep(Query, QueryData.Start, QueryData.Goal, Grid, NextStep, SearchFrom);
+					const bool bRepaired = SearchFrom == FIntPoint::NoneValue
+						|| SearchSuffix(Query, SearchFrom, QueryData.Goal);
+					Times.Add(FPlatformTime::Seconds() - StartTime);
+					Expansions.Add(SearchFrom != FIntPoint::NoneValue ? Pathfinder.GetNumExpanded() : 0);
+
+					TArray<Path::FNode>& RepairedPath = Paths.AddDefaulted_GetRef();
+					const TConstArrayView<FIntPoint> RepairedPoints = PathCache.GetPath(Query);
+					if (bRepaired && RepairedPoints.Num() > 0 && RepairedPoints.Last() == QueryData.Goal)
+					{
+						for (const FIntPoint& Point : RepairedPoints)
+						{
+							RepairedPath.Add(Path::FNode{Point, true});
+						}
+					}
+
+					// The prefix up to the repaired point is kept, so the repaired path costs the prefix plus the
+					// shortest rest of it
+					const int32 RepairFrom = CachedPath.Find(SearchFrom);
+					if (BlockedPoints[Query] != FIntPoint::NoneValue && RepairFrom != INDEX_NONE)
+					{
+						float PrefixCost = 0.f;
+						FString PrefixError;
+						ValidatePath(Grid, QueryData.Start, SearchFrom,
+						             MakeArrayView(CachedPath.GetData(), RepairFrom + 1), PrefixCost, PrefixError);
+						TArray<FIntPoint> RestPath;
+						const float RestCost = FindReferenceCost(Grid, SearchFrom, QueryData.Goal, RestPath);
+						MinCosts[Query] = RestCost < 0.f ? -1.f : PrefixCost + RestCost;
+						MaxCosts[Query] = MinCosts[Query];
+					}
+
+					if (BlockedPoints[Query] != FIntPoint::NoneValue)
+					{
+						Grid.SetUnitId(BlockedPoints[Query], INDEX_NONE);
+					}
+				}
+			}
+			break;
+		}
+
+		FVariantTotals& VariantTotals = OutTotals[Variant];
+		TArray<FIntPoint> PathPoints;
+		for (int32 Query = 0; Query < Queries.Num(); ++Query)
+		{
+			const Path::FQuery& QueryData = Queries[Query];
+			PathPoints.Reset();
+			for (const Path::FNode& Node : Paths[Query])
+			{
+				PathPoints.Add(Node.XY);
+			}
+
+			// An empty path means there is none, the reference has to agree
+			float Cost = -1.f;
+			FString Error;
+			bool bMatch = true;
+			if (BlockedPoints[Query] != FIntPoint::NoneValue)
+			{
+				Grid.SetUnitId(BlockedPoints[Query], ObstacleUnitId);
+			}
+			if (!PathPoints.IsEmpty() && !ValidatePath(Grid, QueryData.Start, QueryData.Goal, PathPoints, Cost, Error))
+			{
+				bMatch = false;
+			}
+			else if ((Cost < 0.f) != (MinCosts[Query] < 0.f) || Cost < MinCosts[Query] - CostTolerance
+				|| Cost > MaxCosts[Query] + CostTolerance)
+			{
+				bMatch = false;
+				Error = FString::Printf(TEXT("the cost is %.3f, the reference one is %.3f, at most %.3f"), Cost,
+				                        MinCosts[Query], MaxCosts[Query]);
+			}
+			if (BlockedPoints[Query] != FIntPoint::NoneValue)
+			{
+				Grid.SetUnitId(BlockedPoints[Query], INDEX_NONE);
+			}
+
+			if (!bMatch)
+			{
+				UE_LOG(LogTask, Error,
+				       TEXT("[IT_PathOracle] Seed %d (%dx%d %s %s%s, density %.2f), %s query %d from %s to %s: %s. "
+					       "Replay with -Seed=%d -Trials=1"),
+				       InSeed, SizeX, SizeY,
+				       *StaticEnum<EGridType>()->GetNameStringByValue(StaticCast<int64>(GridType)),
+				       *StaticEnum<EGridCellOrdering>()->GetNameStringByValue(StaticCast<int64>(CellOrdering)),
+				       bTerrain ? TEXT(" terrain") : TEXT(""), Density, OracleVariant.Name, Query,
+				       *QueryData.Start.ToString(), *QueryData.Goal.ToString(), *Error, InSeed);
+				++VariantTotals.Mismatches;
+			}
+
+			++VariantTotals.Queries;
+			VariantTotals.Expansions += Expansions[Query];
+			VariantTotals.Time += Times[Query];
+
+			OutCsvLines.Add(FString::Printf(TEXT("%d,%d,%s,%d,%d,%d,%d,%f,%f,%d,%f,%d"), InSeed, Query,
+			                                OracleVariant.Name, QueryData.Start.X, QueryData.Start.Y,
+			                                QueryData.Goal.X, QueryData.Goal.Y, MinCosts[Query], Cost,
+			                                Expansions[Query], Times[Query] * 1000.0, bMatch ? 1 : 0));
+		}
+	}
+}
+
+float UIT_PathOracleCommandlet::FindReferenceCost(const FGrid& InGrid, const FIntPoint& InStart,
+                                                  const FIntPoint& InGoal, TArray<FIntPoint>& OutPath)
+{
+	// Dijkstra with lazy deletion, deliberately free of the pathfinder's structures
+	TArray<float> Costs;
+	Costs.Init(TNumericLimits<float>::Max(), InGrid.Num());
+	TArray<int32> Parents;
+	Parents.Init(INDEX_NONE, InGrid.Num());
+	OutPath.Reset();
+
+	const int32 GoalIndex = InGrid.GetIndex(InGoal);
+	const int32 StartIndex = InGrid.GetIndex(InStart);
+	Costs[StartIndex] = 0.f;
+
+	TArray<TPair<float, int32>> Frontier;
+	auto ByCost = [](const TPair<float, int32>& A, const TPair<float, int32>& B) { return A.Key < B.Key; };
+	Frontier.HeapPush(TPair<float, int32>{0.f, StartIndex}, ByCost);
+
+	while (!Frontier.IsEmpty())
+	{
+		TPair<float, int32> Entry;
+		Frontier.HeapPop(Entry, ByCost, false);
+		if (Entry.Key > Costs[Entry.Value])
+		{
+			continue;
+		}
+		if (Entry.Value == GoalIndex)
+		{
+			for (int32 Index = GoalIndex; Index != INDEX_NONE; Index = Parents[Index])
+			{
+				OutPath.Add(InGrid.GetCoordinates(Index));
+			}
+			Algo::Reverse(OutPath);
+			return Entry.Key;
+		}
+
+		InGrid.ForEachNeighbor(InGrid.GetCoordinates(Entry.Value), [&](const FGridNeighbor& Neighbor)
+		{
+			if (InGrid.IsOccupied(Neighbor.Index) && Neighbor.Index != GoalIndex)
+			{
+				return;
+			}
+
+			const float Cost = Entry.Key + Neighbor.Cost;
+			if (Cost < Costs[Neighbor.Index])
+			{
+				Costs[Neighbor.Index] = Cost;
+				Parents[Neighbor.Index] = Entry.Value;
+				Frontier.HeapPush(TPair<float, int32>{Cost, Neighbor.Index}, ByCost);
+			}
+		});
+	}
+	return -1.f;
+}
+
+bool UIT_PathOracleCommandlet::ValidatePath(const FGrid& InGrid, const FIntPoint& InStart, const FIntPoint& InGoal,
+                                            TConstArrayView<FIntPoint> InPath, float& OutCost, FString& OutError)
+{
+	if (InPath[0] != InStart || InPath.Last() != InGoal)
+	{
+		OutError = FString::Printf(TEXT("the path goes from %s to %s"), *InPath[0].ToString(),
+		                           *InPath.Last().ToString());
+		return false;
+	}
+
+	OutCost = 0.f;
+	for (int32 Point = 1; Point < InPath.Num(); ++Point)
+	{
+		if (Point < InPath.Num() - 1 && InGrid.IsOccupied(InPath[Point]))
+		{
+			OutError = FString::Printf(TEXT("the path passes the occupied point %s"), *InPath[Point].ToString());
+			return false;
+		}
+
+		float StepCost = -1.f;
+		InGrid.ForEachNeighbor(InPath[Point - 1], [&](const FGridNeighbor& Neighbor)
+		{
+			if (Neighbor.Coordinates == InPath[Point])
+			{
+				StepCost = Neighbor.Cost;
+			}
+		});
+		if (StepCost < 0.f)
+		{
+			OutError = FString::Printf(TEXT("the path jumps from %s to %s"), *InPath[Point - 1].ToString(),
+			                           *InPath[Point].ToString());
+			return false;
+		}
+		OutCost += StepCost;
+	}
+	return true;
+}
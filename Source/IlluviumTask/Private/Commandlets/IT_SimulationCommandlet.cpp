@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Commandlets/IT_SimulationCommandlet.h"
+
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameModes/IT_GameModeDefault.h"
+#include "IlluviumTask/IlluviumTask.h"
+#include "Misc/FileHelper.h"
+
+UIT_SimulationCommandlet::UIT_SimulationCommandlet()
+{
+	IsClient = false;
+	IsEditor = false;
+	IsServer = false;
+	LogToConsole = true;
+}
+
+int32 UIT_SimulationCommandlet::Main(const FString& Params)
+{
+	FBattleSettings Settings;
+	int32 NumBattles = 1;
+	FString GameModeClassPath;
+	FString CsvPath;
+
+	FParse::Value(*Params, TEXT("Seed="), Settings.Seed);
+	FParse::Value(*Params, TEXT("Battles="), NumBattles);
+	FParse::Value(*Params, TEXT("GridSizeX="), Settings.GridSizeX);
+	FParse::Value(*Params, TEXT("GridSizeY="), Settings.GridSizeY);
+	FParse::Value(*Params, TEXT("ActorsPerTeam="), Settings.ActorsPerTeam);
+	FParse::Value(*Params, TEXT("MaxTurns="), Settings.MaxTurns);
+	FParse::Value(*Params, TEXT("GameMode="), GameModeClassPath);
+	FParse::Value(*Params, TEXT("Csv="), CsvPath);
+	Settings.bSpawnActors = FParse::Param(*Params, TEXT("SpawnActors"));
+
+	if (Settings.GridSizeX <= 0 || Settings.GridSizeY <= 0
+		|| Settings.ActorsPerTeam * 2 > Settings.GridSizeX * Settings.GridSizeY)
+	{
+		UE_LOG(LogTask, Error, TEXT("[IT_Simulation] The actors don't fit on a %dx%d grid."), Settings.GridSizeX,
+		       Settings.GridSizeY);
+		return 1;
+	}
+
+	TSubclassOf<AIT_GameModeDefault> GameModeClass = AIT_GameModeDefault::StaticClass();
+	if (!GameModeClassPath.IsEmpty())
+	{
+		GameModeClass = LoadClass<AIT_GameModeDefault>(nullptr, *GameModeClassPath);
+		if (GameModeClass == nullptr)
+		{
+			UE_LOG(LogTask, Error, TEXT("[IT_Simulation] Failed to load the game mode class %s."), *GameModeClassPath);
+			return 1;
+		}
+	}
+
+	TArray<FString> CsvLines;
+	CsvLines.Add(TEXT("Seed,Turns,WallTime,TurnsPerSecond,Spawn,FlowFields,Paths,Decisions,Apply,Cleanup,EndCheck,"
+		"PathCacheHits,PathCacheRepairs,PathCacheMisses,Winner"));
+
+	TMap<ETeam, int32> WinsPerTeam;
+	int32 TotalTurns = 0;
+	double TotalWallTime = 0.0;
+	const int32 BaseSeed = Settings.Seed;
+
+	for (int32 BattleIndex = 0; BattleIndex < NumBattles; ++BattleIndex)
+	{
+		Settings.Seed = BaseSeed + BattleIndex;
+
+		FBattleResult Result;
+		if (!RunBattle(GameModeClass, Settings, Result))
+		{
+			return 1;
+		}
+
+		const FString WinnerName = StaticEnum<ETeam>()->GetNameStringByValue(StaticCast<int64>(Result.Winner));
+		UE_LOG(LogTask, Display,
+		       TEXT("[IT_Simulation] Seed %d: %d turns in %.3f s (%.1f turns/s). Spawn %.3f s, FlowFields %.3f s, "
+			       "Paths %.3f s, Decisions %.3f s, Apply %.3f s, Cleanup %.3f s, EndCheck %.3f s. "
+			       "Path cache: %d hits, %d repairs, %d misses. Winner: %s"),
+		       Result.Seed, Result.Turns, Result.WallTime, Result.GetTurnsPerSecond(), Result.SpawnTime,
+		       Result.FlowFieldsTime, Result.PathsTime, Result.DecisionsTime, Result.ApplyTime, Result.CleanupTime,
+		       Result.EndCheckTime, Result.PathCacheHits, Result.PathCacheRepairs, Result.PathCacheMisses,
+		       *WinnerName);
+
+		CsvLines.Add(FString::Printf(TEXT("%d,%d,%f,%f,%f,%f,%f,%f,%f,%f,%f,%d,%d,%d,%s"),
+		                             Result.Seed, Result.Turns, Result.WallTime, Result.GetTurnsPerSecond(),
+		                             Result.SpawnTime, Result.FlowFieldsTime, Result.PathsTime, Result.DecisionsTime,
+		                             Result.ApplyTime, Result.CleanupTime, Result.EndCheckTime, Result.PathCacheHits,
+		                             Result.PathCacheRepairs, Result.PathCacheMisses, *WinnerName));
+
+		++WinsPerTeam.FindOrAdd(Result.Winner);
+		TotalTurns += Result.Turns;
+		TotalWallTime += Result.WallTime;
+	}
+
+	UE_LOG(LogTask, Display, TEXT("[IT_Simulation] %d battles, %d turns in %.3f s."), NumBattles, TotalTurns,
+	       TotalWallTime);
+	for (const auto& TeamWins : WinsPerTeam)
+	{
+		UE_LOG(LogTask, Display, TEXT("[IT_Simulation]   %s: %d wins"),
+		       *StaticEnum<ETeam>()->GetNameStringByValue(StaticCast<int64>(TeamWins.Key)), TeamWins.Value);
+	}
+
+	if (!CsvPath.IsEmpty() && !FFileHelper::SaveStringArrayToFile(CsvLines, *CsvPath))
+	{
+		UE_LOG(LogTask, Error, TEXT("[IT_Simulation] Failed to write the report to %s."), *CsvPath);
+		return 1;
+	}
+
+	return 0;
+}
+
+bool UIT_SimulationCommandlet::RunBattle(TSubclassOf<AIT_GameModeDefault> InGameModeClass,
+                                         const FBattleSettings& InSettings, FBattleResult& OutResult) const
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("IT_HeadlessSimulation"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->InitializeActorsForPlay(FURL());
+
+	AIT_GameModeDefault* GameMode = World->SpawnActorDeferred<AIT_GameModeDefault>(InGameModeClass,
+		FTransform::Identity);
+	if (GameMode == nullptr)
+	{
+		UE_LOG(LogTask, Error, TEXT("[IT_Simulation] Failed to spawn the game mode."));
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+		return false;
+	}
+
+	GameMode->SetupSimulation(InSettings.GridSizeX, InSettings.GridSizeY, InSettings.ActorsPerTeam,
+	                          InSettings.bSpawnActors ? EUnitVisualizationMode::Actors : EUnitVisualizationMode::None,
+	                          InSettings.Seed);
+	GameMode->FinishSpawning(FTransform::Identity);
+
+	GameMode->StartHeadlessSimulation();
+	while (GameMode->GetPhaseTimes().NumTurns < InSettings.MaxTurns && GameMode->StepSimulation())
+	{
+	}
+
+	const FSimulationPhaseTimes& PhaseTimes = GameMode->GetPhaseTimes();
+	OutResult.Seed = InSettings.Seed;
+	OutResult.Turns = PhaseTimes.NumTurns;
+	OutResult.SpawnTime = PhaseTimes.Spawn;
+	OutResult.FlowFieldsTime = PhaseTimes.FlowFields;
+	OutResult.PathsTime = PhaseTimes.Paths;
+	OutResult.DecisionsTime = PhaseTimes.Decisions;
+	OutResult.ApplyTime = PhaseTimes.Apply;
+	OutResult.CleanupTime = PhaseTimes.Cleanup;
+	OutResult.EndCheckTime = PhaseTimes.EndCheck;
+	OutResult.PathCacheHits = GameMode->GetPathCache().GetNumHits();
+	OutResult.PathCacheRepairs = GameMode->GetPathCache().GetNumRepairs();
+	OutResult.PathCacheMisses = GameMode->GetPathCache().GetNumMisses();
+	OutResult.Winner = GameMode->GetWinningTeam();
+
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+
+	OutResult.WallTime = FPlatformTime::Seconds() - StartTime;
+	return true;
+}
@@ -3,9 +3,52 @@
 
 #include "GameModes/IT_GameModeDefault.h"
 #include "Actors/IT_GameActorBase.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Actors/IT_UnitInstancedRenderer.h"
+#include "Grid/IT_CooperativePlanner.h"
 #include "Grid/IT_GridTestActor.h"
+#include "Grid/IT_HierarchicalPathfinder.h"
+#include "Grid/IT_PathRequestQueue.h"
 #include "Grid/IT_Pathfinder.h"
+#include "Grid/IT_TerrainMap.h"
 #include "IlluviumTask/IlluviumTask.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("IlluviumSimulation"), STATGROUP_IlluviumSimulation, STATCAT_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Spawn"), STAT_IT_Spawn, STATGROUP_IlluviumSimulation);
+DECLARE_CYCLE_STAT(TEXT("Turn"), STAT_IT_Turn, STATGROUP_IlluviumSimulation);
+DECLARE_CYCLE_STAT(TEXT("Flow Fields"), STAT_IT_FlowFields, STATGROUP_IlluviumSimulation);
+DECLARE_CYCLE_STAT(TEXT("Paths"), STAT_IT_Paths, STATGROUP_IlluviumSimulation);
+DECLARE_CYCLE_STAT(TEXT("Decisions"), STAT_IT_Decisions, STATGROUP_IlluviumSimulation);
+DECLARE_CYCLE_STAT(TEXT("Apply"), STAT_IT_Apply, STATGROUP_IlluviumSimulation);
+DECLARE_CYCLE_STAT(TEXT("Cleanup"), STAT_IT_Cleanup, STATGROUP_IlluviumSimulation);
+DECLARE_CYCLE_STAT(TEXT("End Check"), STAT_IT_EndCheck, STATGROUP_IlluviumSimulation);
+
+TRACE_DECLARE_INT_COUNTER(PathsPerTurn, TEXT("Paths Per Turn"));
+TRACE_DECLARE_INT_COUNTER(RedUnitsAlive, TEXT("Red Units Alive"));
+TRACE_DECLARE_INT_COUNTER(BlueUnitsAlive, TEXT("Blue Units Alive"));
+TRACE_DECLARE_INT_COUNTER(ActorsSpawned, TEXT("Actors Spawned"));
+TRACE_DECLARE_INT_COUNTER(ActorsDestroyed, TEXT("Actors Destroyed"));
+
+// Names the simulation phase for Unreal Insights (-trace=cpu) and times it for "stat IlluviumSimulation"
+#define IT_SIMULATION_PHASE_SCOPE(Phase) \
+	TRACE_CPUPROFILER_EVENT_SCOPE(IT_##Phase); \
+	SCOPE_CYCLE_COUNTER(STAT_IT_##Phase)
+
+static void TraceUnitsAlive(ETeam InTeam, int32 InNumAlive)
+{
+	if (InTeam == ETeam::RedTeam)
+	{
+		TRACE_COUNTER_SET(RedUnitsAlive, InNumAlive);
+	}
+	else if (InTeam == ETeam::BlueTeam)
+	{
+		TRACE_COUNTER_SET(BlueUnitsAlive, InNumAlive);
+	}
+}
 
 
 AIT_GameModeDefault::AIT_GameModeDefault(const FObjectInitializer& ObjectInitializer)
@@ -16,6 +59,7 @@ AIT_GameModeDefault::AIT_GameModeDefault(const FObjectInitializer& ObjectInitial
 
 	bStartPlayersAsSpectators = true;
 	ActorClass = AIT_GameActorBase::StaticClass();
+	InstancedRendererClass = AIT_UnitInstancedRenderer::StaticClass();
 
 	//Pathfinder = MakeUnique<IT_Pathfinder>();
 	Pathfinder = MakePimpl<IT_Pathfinder>();
@@ -23,8 +67,9 @@ AIT_GameModeDefault::AIT_GameModeDefault(const FObjectInitializer& ObjectInitial
 
 void AIT_GameModeDefault::TestGrid()
 {
-	for (auto& Point : Grid.GetGrid())
+	for (int32 Index = 0; Index < Grid.Num(); ++Index)
 	{
+		const FGridPoint Point = Grid.At(Index);
 		if (auto* const World = GetWorld())
 		{
 			FTransform SpawnTransform;
@@ -42,12 +87,47 @@ void AIT_GameModeDefault::PostInitializeComponents()
 {
 	Super::PostInitializeComponents();
 
-	Grid.Init(GridSizeX, GridSizeY, EGridType::Rectangular);
+	if (RandomSeed < 0)
+	{
+		RandomSeed = StaticCast<int32>(FPlatformTime::Cycles() & MAX_int32);
+		UE_LOG(LogTask, Display, TEXT("[AIT_GameModeDefault::PostInitializeComponents] Random seed: %d."), RandomSeed);
+	}
+	Random.Init(RandomSeed);
+	SpawnRandom = Random.MakeStream(ESimulationRandomStream::SpawnPoints);
+	StatsRandom = Random.MakeStream(ESimulationRandomStream::UnitStats);
+
+	const bool bHasTerrain = TerrainMap != nullptr && TerrainMap->IsValid();
+	if (bHasTerrain)
+	{
+		GridSizeX = TerrainMap->SizeX;
+		GridSizeY = TerrainMap->SizeY;
+	}
+
+	Grid.Init(GridSizeX, GridSizeY, GridType, GridCellOrdering);
+	if (bHasTerrain)
+	{
+		Grid.SetTerrain(TerrainMap->Costs);
+	}
+	SpatialIndex.Init(GridSizeX, GridSizeY, SpatialIndexBucketSize);
 
 	if (Pathfinder.IsValid())
 	{
 		Pathfinder->InitGraph(Grid);
 	}
+	if (NavigationMode == EUnitNavigationMode::Pathfinding && HierarchicalPathDistance > 0)
+	{
+		HierarchicalPathfinder = MakePimpl<IT_HierarchicalPathfinder>();
+		HierarchicalPathfinder->Init(Grid, PathClusterSize);
+	}
+	if (NavigationMode == EUnitNavigationMode::Pathfinding && bAsyncPathfinding)
+	{
+		PathRequests = MakePimpl<IT_PathRequestQueue>();
+	}
+	if (NavigationMode == EUnitNavigationMode::Cooperative)
+	{
+		CooperativePlanner = MakePimpl<IT_CooperativePlanner>();
+		CooperativePlanner->Init(Grid, CooperativeWindow);
+	}
 }
 
 void AIT_GameModeDefault::Tick(float DeltaSeconds)
@@ -56,14 +136,14 @@ void AIT_GameModeDefault::Tick(float DeltaSeconds)
 
 	if (bSimulationOngoing)
 	{
-		TimeStepAccumulator += DeltaSeconds;
-
-		if (TimeStepAccumulator >= SimulationTimeStep_ms)
+		const int32 NumSteps = StepScheduler.Advance(DeltaSeconds);
+		for (int32 Step = 0; Step < NumSteps && bSimulationOngoing; ++Step)
 		{
 			MakeSimulationTurn();
-
-			TimeStepAccumulator = 0.f;
 		}
+
+		// The visuals trail the simulation by one step, interpolating towards its current state
+		UpdateUnitVisuals(bSimulationOngoing ? StepScheduler.GetAlpha() : 1.f);
 	}
 }
 
@@ -77,100 +157,245 @@ void AIT_GameModeDefault::BeginPlay()
 
 void AIT_GameModeDefault::SpawnActorAt(TSubclassOf<AIT_GameActorBase> InActorClass, FIntPoint InGridPoint, ETeam InTeam)
 {
-	UWorld* World = GetWorld();
-	if (World == nullptr)
+	if (!Grid.IsPointOnGrid(InGridPoint) || Grid.IsOccupied(InGridPoint) || Grid.IsBlocked(InGridPoint))
 	{
-		UE_LOG(LogTask, Warning, TEXT("[SpawnActorAt] World is nullptr."))
+		UE_LOG(LogTask, Warning, TEXT("[SpawnActorAt] Grid point %s is not available."), *InGridPoint.ToString());
 		return;
 	}
 
-	AIT_GameActorBase* SpawnedActor = World->SpawnActorDeferred<AIT_GameActorBase>(
-		ActorClass,
-		FTransform(), nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+	AddUnit(InTeam, InGridPoint, InActorClass);
+}
 
-	SpawnedActor->SetTeam(InTeam);
+void AIT_GameModeDefault::K2_StartSimulation()
+{
+	StartSimulation();
+}
+
+void AIT_GameModeDefault::SetupSimulation(int32 InGridSizeX, int32 InGridSizeY, int32 InNumberOfActorsPerTeam,
+                                          EUnitVisualizationMode InVisualizationMode, int32 InRandomSeed)
+{
+	checkf(!IsActorInitialized(), TEXT("[AIT_GameModeDefault::SetupSimulation] The grid is already initialized."));
+	GridSizeX = InGridSizeX;
+	GridSizeY = InGridSizeY;
+	NumberOfActorsPerTeam = InNumberOfActorsPerTeam;
+	VisualizationMode = InVisualizationMode;
+	RandomSeed = InRandomSeed;
+}
 
-	SpawnedActor->SetAttackPower(FMath::RandRange(AttackPowerMin, AttackPowerMax));
-	SpawnedActor->SetHealthPoints(FMath::RandRange(HealthPointsMin, HealthPointsMax));
+void AIT_GameModeDefault::StartHeadlessSimulation()
+{
+	SpawnActors();
+	StartSimulation();
+}
 
-	FGridPoint& GridPoint = Grid.At(InGridPoint);
-	GridPoint.GameActor = SpawnedActor;
+bool AIT_GameModeDefault::StepSimulation()
+{
+	if (bSimulationOngoing)
+	{
+		MakeSimulationTurn();
+	}
+	return bSimulationOngoing;
+}
 
-	FTransform SpawnTransform{};
-	SpawnTransform.SetLocation(GridToGlobal(GridPoint.GridCoords));
+bool AIT_GameModeDefault::IsSimulationOngoing() const
+{
+	return bSimulationOngoing;
+}
 
-	GridPoint.GameActor = SpawnedActor;
-	SpawnedActor->GridPointIndex = Grid.At(GridPoint.Index).Index;
-	SpawnedActor->SetGridCoordinates(InGridPoint);
+ETeam AIT_GameModeDefault::GetWinningTeam() const
+{
+	for (const auto& TeamActorsNum : ActorsNumPerTeam)
+	{
+		if (TeamActorsNum.Value > 0 && TeamActorsNum.Value == NumLivingUnits)
+		{
+			return TeamActorsNum.Key;
+		}
+	}
+	return ETeam::NoTeam;
+}
 
-	SpawnedActor->FinishSpawning(SpawnTransform);
+const FSimulationPhaseTimes& AIT_GameModeDefault::GetPhaseTimes() const
+{
+	return PhaseTimes;
+}
 
-	GameActors.Add(SpawnedActor);
+const IT_PathCache& AIT_GameModeDefault::GetPathCache() const
+{
+	return PathCache;
 }
 
-void AIT_GameModeDefault::K2_StartSimulation()
+SIZE_T AIT_GameModeDefault::GetSimulationAllocatedSize() const
 {
-	StartSimulation();
+	SIZE_T Size = Grid.GetAllocatedSize() + Units.GetAllocatedSize() + SpatialIndex.GetAllocatedSize()
+		+ FlowFields.GetAllocatedSize() + PathCache.GetAllocatedSize() + PathSteps.GetAllocatedSize()
+		+ Decisions.GetAllocatedSize();
+	for (const auto& FlowField : FlowFields)
+	{
+		Size += FlowField.Value.GetAllocatedSize();
+	}
+	if (Pathfinder.IsValid())
+	{
+		Size += Pathfinder->GetAllocatedSize();
+	}
+	if (HierarchicalPathfinder.IsValid())
+	{
+		Size += HierarchicalPathfinder->GetAllocatedSize();
+	}
+	if (PathRequests.IsValid())
+	{
+		Size += PathRequests->GetAllocatedSize();
+	}
+	if (CooperativePlanner.IsValid())
+	{
+		Size += CooperativePlanner->GetAllocatedSize();
+	}
+	return Size;
 }
 
 void AIT_GameModeDefault::SpawnActors()
+{
+	IT_SIMULATION_PHASE_SCOPE(Spawn);
+	const double SpawnStartTime = FPlatformTime::Seconds();
+
+	Units.Reserve(Units.Num() + NumberOfActorsPerTeam * 2/*NumberOfTeams*/);
+	if (VisualizationMode == EUnitVisualizationMode::Actors)
+	{
+		UnitActors.Reserve(Units.Num() + NumberOfActorsPerTeam * 2/*NumberOfTeams*/);
+	}
+
+	// Spawn units. Putting a unit on the point takes it out of the grid's empty points
+	for (int32 Index = 0; Index < NumberOfActorsPerTeam * 2/*NumberOfTeams*/; ++Index)
+	{
+		FGridPoint GridPoint;
+		if (!Grid.FindRandomEmptyPointOnGrid(SpawnRandom, GridPoint))
+		{
+			UE_LOG(LogTask, Warning, TEXT("[AIT_GameModeDefault::SpawnActors] The grid is full."));
+			break;
+		}
+
+		AddUnit(Index % 2 ? ETeam::BlueTeam : ETeam::RedTeam, GridPoint.GridCoords, ActorClass);
+	}
+
+	if (VisualizationMode == EUnitVisualizationMode::Instanced)
+	{
+		SpawnInstancedRenderer();
+	}
+
+	PhaseTimes.Spawn += FPlatformTime::Seconds() - SpawnStartTime;
+}
+
+int32 AIT_GameModeDefault::AddUnit(ETeam InTeam, const FIntPoint& InCoordinates,
+                                   TSubclassOf<AIT_GameActorBase> InActorClass)
+{
+	// Populate the unit with the required gameplay information
+	const float AttackPower = StatsRandom.FRandRange(AttackPowerMin, AttackPowerMax);
+	const float HealthPoints = StatsRandom.FRandRange(HealthPointsMin, HealthPointsMax);
+	const int32 UnitId = Units.AddUnit(InTeam, InCoordinates, HealthPoints, AttackPower, 1);
+
+	// Register it on the grid
+	Grid.SetUnitId(InCoordinates, UnitId);
+	if (HierarchicalPathfinder.IsValid())
+	{
+		HierarchicalPathfinder->MarkDirty(InCoordinates);
+	}
+	SpatialIndex.Add(UnitId, InTeam, InCoordinates);
+	TraceUnitsAlive(InTeam, ++(ActorsNumPerTeam.FindOrAdd(InTeam)));
+	++NumLivingUnits;
+
+	if (VisualizationMode == EUnitVisualizationMode::Actors)
+	{
+		SpawnUnitActor(UnitId, InActorClass);
+	}
+	else if (InstancedRenderer != nullptr)
+	{
+		InstancedRenderer->AddUnits(Units, GridCellSize, Grid.GetGridType());
+	}
+	return UnitId;
+}
+
+void AIT_GameModeDefault::SpawnUnitActor(int32 InUnitId, TSubclassOf<AIT_GameActorBase> InActorClass)
 {
 	UWorld* World = GetWorld();
 	if (!World)
 	{
-		UE_LOG(LogTask, Display, TEXT("[AIT_GameModeDefault::SpawnActors] World ptr is nullptr."));
+		UE_LOG(LogTask, Display, TEXT("[AIT_GameModeDefault::SpawnUnitActor] World ptr is nullptr."));
 		return;
 	}
 
-	TArray<FGridPoint> SpawnLocations;
-	Grid.OnStartSpawningActors();
-	// Spawn actors
-	for (int32 Index = 0; Index < NumberOfActorsPerTeam * 2/*NumberOfTeams*/; ++Index)
-	{
-		// First create an actor and populate it with required gameplay information
-		AIT_GameActorBase* SpawnedActor = World->SpawnActorDeferred<AIT_GameActorBase>(
-			ActorClass,
-			FTransform(), nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+	// First create an actor and populate it with the unit's information for debugging
+	AIT_GameActorBase* SpawnedActor = World->SpawnActorDeferred<AIT_GameActorBase>(
+		InActorClass,
+		FTransform(), nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
 
-		SpawnedActor->SetTeam(Index % 2 ? ETeam::BlueTeam : ETeam::RedTeam);
-		SpawnedActor->SetAttackPower(FMath::RandRange(AttackPowerMin, AttackPowerMax));
-		SpawnedActor->SetHealthPoints(FMath::RandRange(HealthPointsMin, HealthPointsMax));
+	SpawnedActor->SetTeam(Units.Teams[InUnitId]);
+	SpawnedActor->SetAttackPower(Units.AttackPower[InUnitId]);
+	SpawnedActor->SetAttackRange(Units.AttackRange[InUnitId]);
+	SpawnedActor->SetHealthPoints(Units.Health[InUnitId]);
+	SpawnedActor->GridPointIndex = Grid.GetIndex(Units.Positions[InUnitId]);
+	SpawnedActor->SetGridCoordinates(Units.Positions[InUnitId]);
 
-		// Next, pass it to the Grid, or GridManager, or GridGenerator to register it on the grid
-		// if( bool bSuccessful = RegisterActor(SpawnedActor) )
+	// Next, with the unit registered on the Grid, use its coordinates to finalize the spawn
+	FTransform FinalTransform;
+	FinalTransform.SetLocation(GridToGlobal(Units.Positions[InUnitId]));
+	SpawnedActor->FinishSpawning(FinalTransform);
+	TRACE_COUNTER_INCREMENT(ActorsSpawned);
 
-		//re-make FindRandomEmptyPointOnGrid to return an Index, I guess. Get Point ref by that point then
-		FGridPoint GridPoint;
-		Grid.FindRandomEmptyPointOnGrid(GridPoint);
-		FGridPoint& GridPointRef = Grid.At(GridPoint.Index);
-		if (GridPointRef.GameActor)
-		{
-			UE_LOG(LogTask, Display, TEXT("[AIT_GameModeDefault::SpawnActors] Received an occupied grid point."));
-		}
-		// Do Grid related stuff here.
-		GridPointRef.GameActor = SpawnedActor;
-		SpawnedActor->GridPointIndex = GridPointRef.Index;
-		SpawnedActor->SetGridCoordinates(GridPointRef.GridCoords);
+	if (UnitActors.Num() <= InUnitId)
+	{
+		UnitActors.SetNum(InUnitId + 1);
+	}
+	UnitActors[InUnitId] = SpawnedActor;
+}
 
+void AIT_GameModeDefault::SpawnInstancedRenderer()
+{
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		UE_LOG(LogTask, Display, TEXT("[AIT_GameModeDefault::SpawnInstancedRenderer] World ptr is nullptr."));
+		return;
+	}
 
-		// --
-		// Next, with an Actor registered on the Grid, it should know it's Grid coordinates.
-		// Use them to finalize the spawn
-		FTransform FinalTransform;
-		FinalTransform.SetLocation(GridToGlobal(SpawnedActor->GetGridCoordinates()));
-		SpawnedActor->FinishSpawning(FinalTransform);
+	if (InstancedRenderer == nullptr)
+	{
+		InstancedRenderer = World->SpawnActor<AIT_UnitInstancedRenderer>(InstancedRendererClass, FTransform());
+	}
 
-		++(ActorsNumPerTeam.FindOrAdd(SpawnedActor->GetTeam()));
-		GameActors.Add(SpawnedActor);
+	if (InstancedRenderer != nullptr)
+	{
+		InstancedRenderer->AddUnits(Units, GridCellSize, Grid.GetGridType());
 	}
-	Grid.OnFinishSpawningActors();
 }
 
 void AIT_GameModeDefault::StartSimulation()
 {
+	StepScheduler.Init(SimulationTimeStep, MaxSimulationStepsPerFrame);
+	PathCache.Init(Units.Num(), PathCacheRegionSize);
+	if (PathRequests.IsValid())
+	{
+		PathRequests->Init(Grid, MaxPathRequestsPerTurn,
+		                   FMath::Max(FTaskGraphInterface::Get().GetNumWorkerThreads(), 1), PathSearchMode);
+	}
 	bSimulationOngoing = true;
 }
 
+void AIT_GameModeDefault::UpdateUnitVisuals(float InAlpha)
+{
+	if (InstancedRenderer != nullptr)
+	{
+		InstancedRenderer->UpdateInstances(Units, InAlpha);
+	}
+
+	for (int32 UnitId = 0; UnitId < UnitActors.Num(); ++UnitId)
+	{
+		if (UnitActors[UnitId] != nullptr && Units.IsAlive(UnitId))
+		{
+			UnitActors[UnitId]->MoveActorInterp(GridToGlobal(Units.PreviousPositions[UnitId]),
+			                                    GridToGlobal(Units.Positions[UnitId]), InAlpha);
+		}
+	}
+}
+
 void AIT_GameModeDefault::EndSimulation()
 {
 	bSimulationOngoing = false;
@@ -182,7 +407,7 @@ void AIT_GameModeDefault::IsSimulationOver()
 	for (auto& TeamActorsNum : ActorsNumPerTeam)
 	{
 		// Technically we check, if any of teams is the only one that is left on the board.
-		if (TeamActorsNum.Value == GameActors.Num())
+		if (TeamActorsNum.Value == NumLivingUnits)
 		{
 			EndSimulation();
 			break;
@@ -194,194 +419,527 @@ void AIT_GameModeDefault::MakeSimulationTurn()
 {
 	// If there is just one, or even no Actors - cease the simulation
 	// TODO: remove or modify this condition into "CanStartSimultaionTurn" 
-	if (GameActors.Num() <= 1)
+	if (NumLivingUnits <= 1)
 	{
 		UE_LOG(LogTask, Display, TEXT("[AIT_GameModeDefault::MakeSimulationTurn] Simulation is over."))
 		bSimulationOngoing = false;
 		return;
 	}
 
-	// for each actor:
-	for (auto* Actor : GameActors)
+	IT_SIMULATION_PHASE_SCOPE(Turn);
+
+	// The visuals interpolate from here to the end of the turn
+	Units.SavePreviousPositions();
+
+	double PhaseStartTime = FPlatformTime::Seconds();
+	auto EndPhase = [&PhaseStartTime](double& OutPhaseTime)
 	{
-		// find closest
-		int32 DistanceSqr = 0;
-		if (auto* TargetActor = FindClosestActor(Actor, DistanceSqr))
+		const double Now = FPlatformTime::Seconds();
+		OutPhaseTime += Now - PhaseStartTime;
+		PhaseStartTime = Now;
+	};
+
+	{
+		IT_SIMULATION_PHASE_SCOPE(FlowFields);
+		if (NavigationMode == EUnitNavigationMode::FlowField)
 		{
-			if (DistanceSqr <= FMath::Square(Actor->GetAttackRange()))
-			{
-				ActorAttack(TargetActor, Actor);
-			}
-			else
-			{
-				ActorMoveTowards(TargetActor, Actor);
-			}
+			BuildFlowFields();
 		}
-		else
+	}
+	EndPhase(PhaseTimes.FlowFields);
+
+	{
+		IT_SIMULATION_PHASE_SCOPE(Paths);
+		if (NavigationMode == EUnitNavigationMode::Pathfinding)
+		{
+			FindPathSteps();
+		}
+		else if (NavigationMode == EUnitNavigationMode::Cooperative)
 		{
-			UE_LOG(LogTask, Warning,
-			       TEXT("[AIT_GameModeDefault::MakeSimulationTurn] Failed to find the closest actor."));
+			PlanCooperativeSteps();
 		}
 	}
+	EndPhase(PhaseTimes.Paths);
+
+	// Each living unit decides on its action. The decisions only read the simulation state, so they don't depend on
+	// the order the units are processed in.
+	{
+		IT_SIMULATION_PHASE_SCOPE(Decisions);
+		static constexpr int32 MinDecisionsBatchSize = 64;
+		Decisions.SetNum(Units.Num());
+		ParallelFor(TEXT("IT_UnitDecisions"), Units.Num(), MinDecisionsBatchSize, [this](int32 UnitId)
+		{
+			Decisions[UnitId] = Units.IsAlive(UnitId) ? DecideUnitAction(UnitId) : FUnitDecision();
+		}, bParallelDecisions ? EParallelForFlags::None : EParallelForFlags::ForceSingleThread);
+	}
+	EndPhase(PhaseTimes.Decisions);
+
+	{
+		IT_SIMULATION_PHASE_SCOPE(Apply);
+		ApplyDecisions();
+	}
+	EndPhase(PhaseTimes.Apply);
 
 	// Clean-up
-	for (auto* Actor : KilledGameActors)
 	{
-		GameActors.Remove(Actor);
-		Actor->StartDestroy();
+		IT_SIMULATION_PHASE_SCOPE(Cleanup);
+		for (const int32 UnitId : KilledUnits)
+		{
+			if (UnitActors.IsValidIndex(UnitId) && UnitActors[UnitId] != nullptr)
+			{
+				UnitActors[UnitId]->StartDestroy();
+				UnitActors[UnitId] = nullptr;
+				TRACE_COUNTER_INCREMENT(ActorsDestroyed);
+			}
+		}
+		KilledUnits.Reset();
 	}
-	KilledGameActors.Empty();
+	EndPhase(PhaseTimes.Cleanup);
 
 	// Check simulation end conditions
-	IsSimulationOver();
+	{
+		IT_SIMULATION_PHASE_SCOPE(EndCheck);
+		IsSimulationOver();
+	}
+	EndPhase(PhaseTimes.EndCheck);
+
+	++PhaseTimes.NumTurns;
+}
+
+FUnitDecision AIT_GameModeDefault::DecideUnitAction(int32 InActionUnitId) const
+{
+	FUnitDecision Decision;
+
+	if (NavigationMode == EUnitNavigationMode::FlowField && DecideFlowFieldAction(InActionUnitId, Decision))
+	{
+		return Decision;
+	}
+
+	// find closest
+	int32 DistanceSqr = 0;
+	const int32 TargetUnitId = FindClosestActor(InActionUnitId, DistanceSqr);
+	if (TargetUnitId == INDEX_NONE)
+	{
+		UE_LOG(LogTask, Warning, TEXT("[AIT_GameModeDefault::DecideUnitAction] Failed to find the closest actor."));
+		return Decision;
+	}
+
+	if (DistanceSqr <= FMath::Square(Units.AttackRange[InActionUnitId]))
+	{
+		Decision.Action = FUnitDecision::EAction::Attack;
+		Decision.TargetUnitId = TargetUnitId;
+	}
+	else if (NavigationMode == EUnitNavigationMode::Cooperative && PathSteps.IsValidIndex(InActionUnitId)
+		&& PathSteps[InActionUnitId] != FIntPoint::NoneValue)
+	{
+		// The planned point may still be occupied by a unit that leaves it this turn. A wait is not a move
+		if (PathSteps[InActionUnitId] != Units.Positions[InActionUnitId])
+		{
+			Decision.Action = FUnitDecision::EAction::Move;
+			Decision.MoveCoordinates = PathSteps[InActionUnitId];
+		}
+	}
+	else if (NavigationMode == EUnitNavigationMode::Pathfinding && PathSteps.IsValidIndex(InActionUnitId)
+		&& PathSteps[InActionUnitId] != FIntPoint::NoneValue && !Grid.IsOccupied(PathSteps[InActionUnitId]))
+	{
+		Decision.Action = FUnitDecision::EAction::Move;
+		Decision.MoveCoordinates = PathSteps[InActionUnitId];
+	}
+	else if (GetNextMoveLocation(InActionUnitId, TargetUnitId, Grid, Decision.MoveCoordinates))
+	{
+		Decision.Action = FUnitDecision::EAction::Move;
+	}
+	else
+	{
+		UE_LOG(LogTask, Verbose, TEXT("[AIT_GameModeDefault::DecideUnitAction] Failed to find a point closer"));
+	}
+
+	return Decision;
 }
 
-AIT_GameActorBase* AIT_GameModeDefault::FindClosestActor(AIT_GameActorBase* InActor, int32& OutDistanceSqr)
+void AIT_GameModeDefault::ApplyDecisions()
 {
-	AIT_GameActorBase* TargetActor = nullptr;
+	// Attacks. The kills wait until every attack is dealt, the kill is credited to the unit that dealt the final blow
+	TArray<TPair<int32, int32>> Kills;
+	for (int32 UnitId = 0; UnitId < Decisions.Num(); ++UnitId)
+	{
+		const FUnitDecision& Decision = Decisions[UnitId];
+		if (Decision.Action == FUnitDecision::EAction::Attack && ActorAttack(Decision.TargetUnitId, UnitId))
+		{
+			Kills.Emplace(Decision.TargetUnitId, UnitId);
+		}
+	}
 
-	if (InActor == nullptr)
+	for (const auto& Kill : Kills)
 	{
-		UE_LOG(LogTask, Warning, TEXT("[AIT_GameModeDefault::FindClosestActor] Use of null pointer."))
-		return TargetActor;
+		HandleActorKilled(Kill.Key, Kill.Value);
 	}
 
-	int32 ClosestDist = -1;
-	AIT_GameActorBase* ClosestTarget = nullptr;
-	// TODO: upon adding new actors, put them into separate arrays, and iterate through the opponents array here.
-	for (auto* Actor : GameActors)
+	// Moves. A destination can be occupied by a unit with a lower id that has moved there this turn. In the
+	// Cooperative navigation mode it can also be occupied by a unit that is planned to leave it, so the blocked moves
+	// are retried in the id order until none of them can be made.
+	TArray<int32> BlockedUnits;
+	for (int32 UnitId = 0; UnitId < Decisions.Num(); ++UnitId)
 	{
-		if (Actor == InActor || !Actor->IsAlive())
+		const FUnitDecision& Decision = Decisions[UnitId];
+		if (Decision.Action != FUnitDecision::EAction::Move || !Units.IsAlive(UnitId))
 		{
 			continue;
 		}
 
-		if (InActor->GetTeam() != Actor->GetTeam())
+		if (Grid.IsOccupied(Decision.MoveCoordinates))
 		{
-			FIntPoint Diff = InActor->GetGridCoordinates() - Actor->GetGridCoordinates();
-			const int32 DistSqr = FIntPoint(InActor->GetGridCoordinates() - Actor->GetGridCoordinates()).SizeSquared();
+			BlockedUnits.Add(UnitId);
+			continue;
+		}
 
-			if ((ClosestDist < 0) || (DistSqr < ClosestDist))
-			{
-				ClosestDist = DistSqr;
-				ClosestTarget = Actor;
-			}
+		MoveActorTo(UnitId, Decision.MoveCoordinates);
+	}
 
-			// Maybe, this is a good idea to break as soon as we find an actor that is one square away from us.
-			if (DistSqr <= 1)
+	for (bool bHasMoved = true; bHasMoved && BlockedUnits.Num() > 0;)
+	{
+		bHasMoved = false;
+		for (int32 Blocked = 0; Blocked < BlockedUnits.Num();)
+		{
+			const int32 UnitId = BlockedUnits[Blocked];
+			if (Grid.IsOccupied(Decisions[UnitId].MoveCoordinates))
 			{
-				break;
+				++Blocked;
+				continue;
 			}
+
+			MoveActorTo(UnitId, Decisions[UnitId].MoveCoordinates);
+			BlockedUnits.RemoveAt(Blocked, 1, false);
+			bHasMoved = true;
 		}
 	}
 
-	if (ClosestTarget != nullptr)
+	for (const int32 UnitId : BlockedUnits)
 	{
-		OutDistanceSqr = ClosestDist;
+		UE_LOG(LogTask, Verbose, TEXT("[AIT_GameModeDefault::ApplyDecisions] %d lost its move to %d."), UnitId,
+		       Grid.GetUnitId(Grid.GetIndex(Decisions[UnitId].MoveCoordinates)));
 	}
+}
 
-	return ClosestTarget;
+int32 AIT_GameModeDefault::FindClosestActor(int32 InUnitId, int32& OutDistanceSqr) const
+{
+	return SpatialIndex.FindClosestOpponent(Units.Positions[InUnitId], Units.Teams[InUnitId], OutDistanceSqr);
 }
 
-void AIT_GameModeDefault::ActorAttack(AIT_GameActorBase* InTargetActor, AIT_GameActorBase* InActionActor)
+bool AIT_GameModeDefault::ActorAttack(int32 InTargetUnitId, int32 InActionUnitId)
 {
-	UE_LOG(LogTask, Display, TEXT("[AIT_GameModeDefault::ActorAttack] Target: %s, Instigator %s."),
-	       *GetNameSafe(InTargetActor), *GetNameSafe(InActionActor));
+	UE_LOG(LogTask, Verbose, TEXT("[AIT_GameModeDefault::ActorAttack] Target: %d, Instigator %d."),
+	       InTargetUnitId, InActionUnitId);
 
-	if (!InTargetActor || !InActionActor)
-	{
-		UE_LOG(LogTask, Warning, TEXT("[AIT_GameModeDefault::ActorAttack] One of the actors is nullptr."));
-		return;
-	}
-	InTargetActor->SetHealthPoints(InTargetActor->GetHealthPoints() - InActionActor->GetAttackPower());
-	if (InTargetActor->GetHealthPoints() <= 0.f)
+	const bool bWasAlive = Units.Health[InTargetUnitId] > 0.f;
+	Units.Health[InTargetUnitId] -= Units.AttackPower[InActionUnitId];
+
+	if (UnitActors.IsValidIndex(InTargetUnitId) && UnitActors[InTargetUnitId] != nullptr)
 	{
-		HandleActorKilled(InTargetActor, InActionActor);
+		UnitActors[InTargetUnitId]->SetHealthPoints(Units.Health[InTargetUnitId]);
 	}
+
+	return bWasAlive && Units.Health[InTargetUnitId] <= 0.f;
 }
 
-FIntPoint AIT_GameModeDefault::GetNextMoveLocation(AIT_GameActorBase* InActionActor, AIT_GameActorBase* InTargetActor,
-                                                   const FGrid& InGrid)
+bool AIT_GameModeDefault::GetNextMoveLocation(int32 InActionUnitId, int32 InTargetUnitId, const FGrid& InGrid,
+                                              FIntPoint& OutCoordinates) const
 {
-	FIntPoint ResultPoint = FIntPoint::ZeroValue;
+	bool bFound = false;
 
-	if (InTargetActor != nullptr)
+	if (InTargetUnitId != INDEX_NONE)
 	{
-		FGridPoint CurrentGridPoint = InGrid.At(InActionActor->GetGridCoordinates());
-		const TArray<FGridPoint> NeighborPoints = Grid.GetNodeConnections(CurrentGridPoint);
+		const FIntPoint& ActionCoordinates = Units.Positions[InActionUnitId];
+		const FIntPoint& TargetCoordinates = Units.Positions[InTargetUnitId];
 
-		int32 LeastDistance = FIntPoint(InTargetActor->GetGridCoordinates() - InActionActor->GetGridCoordinates()).
-			SizeSquared();
+		int32 LeastDistance = FIntPoint(TargetCoordinates - ActionCoordinates).SizeSquared();
 
 		auto IsCloserThanBefore = [&LeastDistance](const FIntPoint& Left, const FIntPoint& Right)
 		{
 			return FIntPoint(Left - Right).SizeSquared() < LeastDistance;
 		};
 
-		for (const auto& Point : NeighborPoints)
+		InGrid.ForEachNeighbor(ActionCoordinates, [&](const FGridNeighbor& Neighbor)
 		{
-			const auto PointCoordinates = Point.GridCoords;
-			if (Point.GameActor == nullptr && IsCloserThanBefore(PointCoordinates, InTargetActor->GetGridCoordinates()))
+			if (!InGrid.IsOccupied(Neighbor.Index) && IsCloserThanBefore(Neighbor.Coordinates, TargetCoordinates))
 			{
-				LeastDistance = FIntPoint(PointCoordinates - InTargetActor->GetGridCoordinates()).SizeSquared();
-				ResultPoint = PointCoordinates;
+				LeastDistance = FIntPoint(Neighbor.Coordinates - TargetCoordinates).SizeSquared();
+				OutCoordinates = Neighbor.Coordinates;
+				bFound = true;
 			}
-		}
+		});
 	}
 
-	return ResultPoint;
+	return bFound;
 }
 
-void AIT_GameModeDefault::ActorMoveTowards(AIT_GameActorBase* InTargetActor, AIT_GameActorBase* InActionActor)
+void AIT_GameModeDefault::MoveActorTo(int32 InUnitId, const FIntPoint& InNewCoordinates)
 {
-	UE_LOG(LogTask, Display, TEXT("[AIT_GameModeDefault::ActorMove] Target: %s, ActionActor %s."),
-	       *GetNameSafe(InTargetActor), *GetNameSafe(InActionActor));
+	SpatialIndex.Move(InUnitId, Units.Teams[InUnitId], Units.Positions[InUnitId], InNewCoordinates);
+
+	// Clear current point on grid, then assign new coordinates to the unit and assign the unit to the new grid point
+	const FIntPoint OldCoordinates = Units.Positions[InUnitId];
+	Grid.SetUnitId(OldCoordinates, INDEX_NONE);
+	Units.Positions[InUnitId] = InNewCoordinates;
+	Grid.SetUnitId(InNewCoordinates, InUnitId);
+	if (HierarchicalPathfinder.IsValid())
+	{
+		HierarchicalPathfinder->MarkDirty(OldCoordinates);
+		HierarchicalPathfinder->MarkDirty(InNewCoordinates);
+	}
 
-	if (InTargetActor == nullptr || InActionActor == nullptr)
+	// Sync the visual actor, if there is one
+	if (UnitActors.IsValidIndex(InUnitId) && UnitActors[InUnitId] != nullptr)
 	{
-		UE_LOG(LogTask, Warning, TEXT("[AIT_GameModeDefault::ActorMove] Nullptr is passed as an argument."));
-		return;
+		AIT_GameActorBase* UnitActor = UnitActors[InUnitId];
+		UnitActor->SetGridCoordinates(InNewCoordinates);
+		UnitActor->GridPointIndex = Grid.GetIndex(InNewCoordinates);
+		// The location itself is interpolated every frame, see UpdateUnitVisuals
 	}
+}
+
+void AIT_GameModeDefault::FindPathSteps()
+{
+	PathSteps.Init(FIntPoint::NoneValue, Units.Num());
+	TArray<FPathRequest> SyncRequests;
+	TArray<FPathRequest> LongRangeRequests;
+	int32 NumPathRequests = 0;
+
+	// Caches the found path of the unit and takes its first step
+	TArray<FIntPoint> Points;
+	TArray<uint32> Versions;
+	auto ApplyPath = [this, &Points, &Versions](int32 InUnitId, TConstArrayView<Path::FNode> InPath)
+	{
+		Points.Reset();
+		Versions.Reset();
+		for (const Path::FNode& Node : InPath)
+		{
+			Points.Add(Node.XY);
+			Versions.Add(Grid.GetOccupancyVersion(Grid.GetIndex(Node.XY)));
+		}
+		PathCache.ApplySuffix(InUnitId, Points, Versions);
 
-	FIntPoint NextMove = GetNextMoveLocation(InActionActor, InTargetActor, Grid);
-	// Alternatively, use pathfinding, if the grid will have obstacles:
-	//auto DummyPath = Pathfinder->FindPath(Path::FNode(InActionActor->GetGridCoordinates()),
-	//                                      Path::FNode(InTargetActor->GetGridCoordinates()));
-	//if(DummyPath.Num() > 0)
-	//{
-	//	NextMove = (*DummyPath.begin()).XY;
-	//}
-	
+		FIntPoint NextStep;
+		if (PathCache.GetNextStep(InUnitId, NextStep))
+		{
+			PathSteps[InUnitId] = NextStep;
+		}
+	};
+
+	// The searches dispatched on the previous turn are done by now, or close to it
+	if (PathRequests.IsValid())
+	{
+		TArray<FPathResult> Results;
+		PathRequests->Collect(Results);
+		for (const FPathResult& Result : Results)
+		{
+			PathCache.ApplySuffix(Result.UnitId, Result.Points, Result.Versions);
+		}
+	}
 
-	if (NextMove == FIntPoint::ZeroValue)
+	for (int32 UnitId = 0; UnitId < Units.Num(); ++UnitId)
 	{
-		UE_LOG(LogTask, Warning, TEXT("[AIT_GameModeDefault::ActorMove] Failed to find a point closer"));
+		if (!Units.IsAlive(UnitId))
+		{
+			continue;
+		}
+
+		int32 DistanceSqr = 0;
+		const int32 TargetUnitId = FindClosestActor(UnitId, DistanceSqr);
+		if (TargetUnitId == INDEX_NONE || DistanceSqr <= FMath::Square(Units.AttackRange[UnitId]))
+		{
+			continue;
+		}
+
+		const FIntPoint& Goal = Units.Positions[TargetUnitId];
+		FIntPoint NextStep;
+		FIntPoint SearchFrom;
+		if (PathCache.FindCachedStep(UnitId, Units.Positions[UnitId], Goal, Grid, NextStep, SearchFrom))
+		{
+			PathSteps[UnitId] = NextStep;
+		}
+		if (SearchFrom == FIntPoint::NoneValue)
+		{
+			continue;
+		}
+
+		++NumPathRequests;
+		if (HierarchicalPathfinder.IsValid() && Grid.GetDistance(SearchFrom, Goal) > HierarchicalPathDistance)
+		{
+			LongRangeRequests.Add(FPathRequest{UnitId, SearchFrom, Goal});
+		}
+		else if (PathRequests.IsValid())
+		{
+			PathRequests->Submit(FPathRequest{UnitId, SearchFrom, Goal});
+		}
+		else
+		{
+			SyncRequests.Add(FPathRequest{UnitId, SearchFrom, Goal});
+		}
+	}
+
+	TRACE_COUNTER_SET(PathsPerTurn, NumPathRequests);
+	for (const FPathRequest& Request : LongRangeRequests)
+	{
+		ApplyPath(Request.UnitId,
+		          HierarchicalPathfinder->FindPath(Path::FNode{Request.Start}, Path::FNode{Request.Goal}));
+	}
+
+	if (PathRequests.IsValid())
+	{
+		PathRequests->Dispatch(Grid);
 		return;
 	}
 
-	// Clear current point on grid, then assign new coordinates to the actor and assign the actor to the new grid point
-	Grid.At(InActionActor->GetGridCoordinates()).GameActor = nullptr;
-	InActionActor->SetGridCoordinates(NextMove);
-	Grid.At(NextMove).GameActor = InActionActor;
+	// The units swarming the same target share a single search
+	TArray<Path::FQuery> Queries;
+	Queries.Reserve(SyncRequests.Num());
+	for (const FPathRequest& Request : SyncRequests)
+	{
+		Queries.Add(Path::FQuery{Request.Start, Request.Goal});
+	}
+	const TArray<TArray<Path::FNode>> Paths = Pathfinder->FindPaths(Queries, PathSearchMode);
+	if (Queries.Num() > 0)
+	{
+		IT_Pathfinder::TraceExpanded(Queries.Num(), Pathfinder->GetNumExpanded());
+	}
+	for (int32 RequestIndex = 0; RequestIndex < SyncRequests.Num(); ++RequestIndex)
+	{
+		ApplyPath(SyncRequests[RequestIndex].UnitId, Paths[RequestIndex]);
+	}
+}
+
+void AIT_GameModeDefault::PlanCooperativeSteps()
+{
+	PathSteps.Init(FIntPoint::NoneValue, Units.Num());
+	CooperativePlanner->BeginTurn();
 
+	// The units that stay keep their points for the whole window, the others only for the current turn
+	TArray<TPair<int32, int32>> MovingUnits;
+	for (int32 UnitId = 0; UnitId < Units.Num(); ++UnitId)
+	{
+		if (!Units.IsAlive(UnitId))
+		{
+			continue;
+		}
 
-	// TODO: fix the lerp first. Then delete the SetActorLocation call.
-	//InActionActor->MoveActorInterp(GridToGlobal(NextMove), SimulationTimeStep_ms);
-	InActionActor->SetActorLocation(GridToGlobal(NextMove));
+		int32 DistanceSqr = 0;
+		const int32 TargetUnitId = FindClosestActor(UnitId, DistanceSqr);
+		if (TargetUnitId == INDEX_NONE || DistanceSqr <= FMath::Square(Units.AttackRange[UnitId]))
+		{
+			CooperativePlanner->ReserveStationary(UnitId, Units.Positions[UnitId]);
+			continue;
+		}
+
+		CooperativePlanner->ReserveStart(UnitId, Units.Positions[UnitId]);
+		MovingUnits.Emplace(UnitId, TargetUnitId);
+	}
+
+	for (const auto& MovingUnit : MovingUnits)
+	{
+		FIntPoint NextStep;
+		CooperativePlanner->PlanUnit(MovingUnit.Key, Units.Positions[MovingUnit.Key],
+		                             Units.Positions[MovingUnit.Value], NextStep);
+		PathSteps[MovingUnit.Key] = NextStep;
+	}
+	TRACE_COUNTER_SET(PathsPerTurn, MovingUnits.Num());
 }
 
-void AIT_GameModeDefault::HandleActorKilled(AIT_GameActorBase* InTargetActor, AIT_GameActorBase* InInstigatorActor)
+void AIT_GameModeDefault::BuildFlowFields()
 {
-	UE_LOG(LogTask, Warning, TEXT("[AIT_GameModeDefault::HandleActorKilled] %s is killed by %s."),
-	       *GetNameSafe(InTargetActor), *GetNameSafe(InInstigatorActor));
+	TArray<int32> SourceIndices;
+	SourceIndices.Reserve(NumLivingUnits);
 
-	InTargetActor->HandleZeroHealth();
-	Grid.At(InTargetActor->GetGridCoordinates()).GameActor = nullptr;
-	KilledGameActors.Add(InTargetActor);
-	--ActorsNumPerTeam.FindOrAdd(InTargetActor->GetTeam());
+	for (const auto& TeamActorsNum : ActorsNumPerTeam)
+	{
+		const ETeam Team = TeamActorsNum.Key;
+
+		SourceIndices.Reset();
+		for (int32 UnitId = 0; UnitId < Units.Num(); ++UnitId)
+		{
+			if (Units.IsAlive(UnitId) && Units.Teams[UnitId] != Team)
+			{
+				SourceIndices.Add(Grid.GetIndex(Units.Positions[UnitId]));
+			}
+		}
+
+		FlowFields.FindOrAdd(Team).Build(Grid, SourceIndices);
+	}
+}
+
+bool AIT_GameModeDefault::DecideFlowFieldAction(int32 InActionUnitId, FUnitDecision& OutDecision) const
+{
+	const ETeam Team = Units.Teams[InActionUnitId];
+	const IT_FlowField* FlowField = FlowFields.Find(Team);
+	if (FlowField == nullptr)
+	{
+		return false;
+	}
+
+	const FIntPoint& ActionCoordinates = Units.Positions[InActionUnitId];
+	const int32 PointIndex = Grid.GetIndex(ActionCoordinates);
+	const int32 SourceIndex = FlowField->GetSourceIndex(PointIndex);
+	if (SourceIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// The field is built on the same grid the decisions are made on, so the source is expected to be a living opponent
+	const int32 TargetUnitId = Grid.GetUnitId(SourceIndex);
+	if (TargetUnitId == INDEX_NONE || !Units.IsAlive(TargetUnitId) || Units.Teams[TargetUnitId] == Team)
+	{
+		return false;
+	}
+
+	const int32 DistanceSqr = FIntPoint(Units.Positions[TargetUnitId] - ActionCoordinates).SizeSquared();
+	if (DistanceSqr <= FMath::Square(Units.AttackRange[InActionUnitId]))
+	{
+		OutDecision.Action = FUnitDecision::EAction::Attack;
+		OutDecision.TargetUnitId = TargetUnitId;
+		return true;
+	}
+
+	const int32 NextIndex = FlowField->GetNextIndex(PointIndex);
+	if (NextIndex == INDEX_NONE || Grid.IsOccupied(NextIndex))
+	{
+		return false;
+	}
+
+	OutDecision.Action = FUnitDecision::EAction::Move;
+	OutDecision.MoveCoordinates = Grid.GetCoordinates(NextIndex);
+	return true;
+}
+
+void AIT_GameModeDefault::HandleActorKilled(int32 InTargetUnitId, int32 InInstigatorUnitId)
+{
+	UE_LOG(LogTask, Verbose, TEXT("[AIT_GameModeDefault::HandleActorKilled] %d is killed by %d."),
+	       InTargetUnitId, InInstigatorUnitId);
+
+	const FIntPoint& TargetCoordinates = Units.Positions[InTargetUnitId];
+	Units.Kill(InTargetUnitId);
+	Grid.SetUnitId(TargetCoordinates, INDEX_NONE);
+	if (HierarchicalPathfinder.IsValid())
+	{
+		HierarchicalPathfinder->MarkDirty(TargetCoordinates);
+	}
+	PathCache.Invalidate(InTargetUnitId);
+	if (PathRequests.IsValid())
+	{
+		PathRequests->Cancel(InTargetUnitId);
+	}
+	SpatialIndex.Remove(InTargetUnitId, Units.Teams[InTargetUnitId], TargetCoordinates);
+	KilledUnits.Add(InTargetUnitId);
+	TraceUnitsAlive(Units.Teams[InTargetUnitId], --ActorsNumPerTeam.FindOrAdd(Units.Teams[InTargetUnitId]));
+	--NumLivingUnits;
+
+	if (UnitActors.IsValidIndex(InTargetUnitId) && UnitActors[InTargetUnitId] != nullptr)
+	{
+		UnitActors[InTargetUnitId]->HandleZeroHealth();
+	}
 }
 
 FVector AIT_GameModeDefault::GridToGlobal(const FIntPoint& InCoordinates) const
 {
-	return FVector{InCoordinates.X * GridCellSize, InCoordinates.Y * GridCellSize, 0.f};
+	const FVector2D LayoutPosition = FGrid::GetLayoutPosition(Grid.GetGridType(), InCoordinates);
+	return FVector{LayoutPosition.X * GridCellSize, LayoutPosition.Y * GridCellSize, 0.f};
 }
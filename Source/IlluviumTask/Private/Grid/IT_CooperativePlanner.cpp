@@ -0,0 +1,153 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Grid/IT_CooperativePlanner.h"
+
+#include "Algo/Reverse.h"
+#include "Grid/IT_Grid.h"
+
+void IT_CooperativePlanner::Init(const FGrid& InGrid, int32 InWindow)
+{
+	Grid = &InGrid;
+	Reservations.Init(InGrid.Num(), InWindow);
+
+	// The neighbors are at most one point away on both axes, so by the time T a search is inside the square of the side
+	// 2 * T + 1 around its start
+	int64 MaxNodes = 0;
+	for (int64 Time = 0; Time <= Reservations.GetWindow(); ++Time)
+	{
+		const int64 Side = 2 * Time + 1;
+		MaxNodes += FMath::Min<int64>(InGrid.GetSizeX(), Side) * FMath::Min<int64>(InGrid.GetSizeY(), Side);
+	}
+	checkf(MaxNodes <= MAX_int32, TEXT("[IT_CooperativePlanner::Init] The window of %d turns is too long."),
+	       Reservations.GetWindow());
+	Scratch.Init(StaticCast<int32>(MaxNodes));
+}
+
+void IT_CooperativePlanner::BeginTurn()
+{
+	Reservations.Reset();
+}
+
+void IT_CooperativePlanner::ReserveStationary(int32 InUnitId, const FIntPoint& InCoordinates)
+{
+	Reservations.ReserveFrom(Grid->GetIndex(InCoordinates), 0, InUnitId);
+}
+
+void IT_CooperativePlanner::ReserveStart(int32 InUnitId, const FIntPoint& InCoordinates)
+{
+	Reservations.Reserve(Grid->GetIndex(InCoordinates), 0, InUnitId);
+}
+
+bool IT_CooperativePlanner::PlanUnit(int32 InUnitId, const FIntPoint& InStart, const FIntPoint& InGoal,
+                                     FIntPoint& OutNextStep)
+{
+	checkf(Grid != nullptr, TEXT("[IT_CooperativePlanner::PlanUnit] The planner is not initialized."));
+
+	const int32 Window = Reservations.GetWindow();
+	const int32 StartIndex = Grid->GetIndex(InStart);
+	const int32 GoalIndex = Grid->GetIndex(InGoal);
+
+	Scratch.Reset();
+	Nodes.Reset();
+	NodeIds.Reset();
+	Scratch.Relax(FindOrAddNode(StartIndex, 0), 0.f, INDEX_NONE, Grid->GetCostEstimate(InStart, InGoal));
+
+	// The search ends at the goal, or at the end of the window where the heuristic takes over
+	int32 LastNode = INDEX_NONE;
+	while (!Scratch.OpenList.IsEmpty())
+	{
+		const int32 Node = Scratch.OpenList.Pop();
+		Scratch.ClosedSet[Node] = true;
+
+		const int32 Time = Nodes[Node].Time;
+		const int32 Index = Nodes[Node].Index;
+		if (Index == GoalIndex || Time == Window)
+		{
+			LastNode = Node;
+			break;
+		}
+
+		auto Visit = [&](int32 InNextIndex, const FIntPoint& InNextCoordinates, float InCost)
+		{
+			// The goal is occupied by the target, but it still terminates the plan
+			if (InNextIndex != GoalIndex && Reservations.IsReservedByOther(InNextIndex, Time + 1, InUnitId))
+			{
+				return;
+			}
+
+			// No swapping places with another unit
+			const int32 NextOwner = Reservations.GetReservation(InNextIndex, Time);
+			if (InNextIndex != Index && NextOwner != INDEX_NONE && NextOwner != InUnitId
+				&& Reservations.GetReservation(Index, Time + 1) == NextOwner)
+			{
+				return;
+			}
+
+			const int32 NextNode = FindOrAddNode(InNextIndex, Time + 1);
+			if (Scratch.ClosedSet[NextNode])
+			{
+				return;
+			}
+
+			Scratch.Relax(NextNode, Scratch.CostSoFar[Node] + InCost, Node,
+			              Grid->GetCostEstimate(InNextCoordinates, InGoal));
+		};
+
+		// Waiting costs a turn, like a straight move
+		const FIntPoint Coordinates = Grid->GetCoordinates(Index);
+		Visit(Index, Coordinates, 1.f);
+		Grid->ForEachNeighbor(Coordinates, [&Visit](const FGridNeighbor& Neighbor)
+		{
+			Visit(Neighbor.Index, Neighbor.Coordinates, Neighbor.Cost);
+		});
+	}
+
+	if (LastNode == INDEX_NONE)
+	{
+		OutNextStep = InStart;
+		Reservations.ReserveFrom(StartIndex, 0, InUnitId);
+		return false;
+	}
+
+	PlanNodes.Reset();
+	for (int32 Node = LastNode; Node != INDEX_NONE; Node = Scratch.ParentIndices[Node])
+	{
+		PlanNodes.Add(Node);
+	}
+	Algo::Reverse(PlanNodes);
+
+	// The target keeps the goal, the unit stays next to it for the rest of the window
+	if (PlanNodes.Num() > 1 && Nodes[PlanNodes.Last()].Index == GoalIndex)
+	{
+		PlanNodes.Pop(false);
+	}
+	for (const int32 Node : PlanNodes)
+	{
+		Reservations.Reserve(Nodes[Node].Index, Nodes[Node].Time, InUnitId);
+	}
+	const FSpaceTimeNode& LastPlanNode = Nodes[PlanNodes.Last()];
+	Reservations.ReserveFrom(LastPlanNode.Index, LastPlanNode.Time, InUnitId);
+
+	OutNextStep = PlanNodes.Num() > 1 ? Grid->GetCoordinates(Nodes[PlanNodes[1]].Index) : InStart;
+	return true;
+}
+
+SIZE_T IT_CooperativePlanner::GetAllocatedSize() const
+{
+	return Reservations.GetAllocatedSize() + Scratch.GetAllocatedSize() + Nodes.GetAllocatedSize()
+		+ NodeIds.GetAllocatedSize() + PlanNodes.GetAllocatedSize();
+}
+
+int32 IT_CooperativePlanner::FindOrAddNode(int32 InIndex, int32 InTime)
+{
+	const int64 Key = StaticCast<int64>(InTime) * Grid->Num() + InIndex;
+	if (const int32* Node = NodeIds.Find(Key))
+	{
+		return *Node;
+	}
+
+	const int32 Node = Nodes.Add(FSpaceTimeNode{InIndex, InTime});
+	NodeIds.Add(Key, Node);
+	return Node;
+}
@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Grid/IT_FlowField.h"
+
+void IT_FlowField::Build(const FGrid& InGrid, TConstArrayView<int32> InSourceIndices)
+{
+	const int32 NumPoints = InGrid.Num();
+	Distances.Init(INDEX_NONE, NumPoints);
+	NextIndices.Init(INDEX_NONE, NumPoints);
+	SourceIndices.Init(INDEX_NONE, NumPoints);
+	Frontier.Reset(NumPoints);
+
+	for (const int32 SourceIndex : InSourceIndices)
+	{
+		if (Distances.IsValidIndex(SourceIndex) && Distances[SourceIndex] == INDEX_NONE)
+		{
+			Distances[SourceIndex] = 0;
+			SourceIndices[SourceIndex] = SourceIndex;
+			Frontier.Add(SourceIndex);
+		}
+	}
+
+	// The frontier array is used as a FIFO queue, every point is added to it once at most
+	for (int32 FrontierPosition = 0; FrontierPosition < Frontier.Num(); ++FrontierPosition)
+	{
+		const int32 CurrentIndex = Frontier[FrontierPosition];
+
+		// Occupied points are reached, but can't be passed through. Sources are occupied by definition
+		if (InGrid.IsOccupied(CurrentIndex) && Distances[CurrentIndex] != 0)
+		{
+			continue;
+		}
+
+		const FIntPoint CurrentCoordinates = InGrid.GetCoordinates(CurrentIndex);
+		InGrid.ForEachNeighbor(CurrentCoordinates, [this, CurrentIndex](const FGridNeighbor& Neighbor)
+		{
+			const int32 NeighborIndex = Neighbor.Index;
+			if (Distances[NeighborIndex] != INDEX_NONE)
+			{
+				return;
+			}
+
+			Distances[NeighborIndex] = Distances[CurrentIndex] + 1;
+			NextIndices[NeighborIndex] = CurrentIndex;
+			SourceIndices[NeighborIndex] = SourceIndices[CurrentIndex];
+			Frontier.Add(NeighborIndex);
+		});
+	}
+}
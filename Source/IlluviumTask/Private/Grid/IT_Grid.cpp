@@ -3,206 +3,209 @@
 
 #include "Grid/IT_Grid.h"
 
-#include "Actors/IT_GameActorBase.h"
 #include "IlluviumTask/IlluviumTask.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "Simulation/IT_SimulationRandom.h"
 
-/*
- * We may use the rules of the Grid formation, like: Rect, Hex, Oct. Which will define the directions in which to check if there is a node
- * NW NN NE | [1;-1]	[1;0]	[1;1]
- * WW OO EE | [0;-1]	[0;0]	[0;1]
- * SW SS SE | [-1;-1]	[-1;0]	[-1;1]
- * Rect: NN, WW, EE, SS connections.
- * Hex: NW, NE, WW, EE, SW, SE connections.
- * Oct: All 8 directions.
- *
- * Using such rules will declare, that all the neighbors are 1 point away from the node with no distance calculations.
- * To check: if the coordinates of interest are in bounds of the Grid size and are not below zero
- * 0 <= X <= Grid.Size.X
- * 0 <= Y <= Grid.Size.Y
- */
-// Grid point coordinates modifiers for neighbors look-up. 
-static const TArray<FIntPoint> RectModifiers
-	{{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
-
-static const TArray<FIntPoint> HexModifiers
-	{{1, 0}, {-1, 0}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
-
-static const TArray<FIntPoint> OctModifiers
-	{{-1, 1}, {0, 1}, {1, 1}, {-1, 0}, {1, 0}, {-1, -1}, {0, -1}, {1, -1}};
-
-// Use mapping to get a required array based on the Grid type
-static const TMap<EGridType, TArray<FIntPoint>> GridModifiersMapping
-{
-	{EGridType::Rectangular, RectModifiers},
-	{EGridType::Hexagonal, HexModifiers},
-	{EGridType::Octagonal, OctModifiers}
-};
-//--
+TRACE_DECLARE_INT_COUNTER(GridWrites, TEXT("Grid Writes"));
 
 void FGrid::PrintGrid() const
 {
-	for (auto& Point : GridArray)
+	for (int32 Index = 0; Index < Num(); ++Index)
 	{
-		UE_LOG(LogTask, Display, TEXT("%s"), *Point.GetDebugString());
+		UE_LOG(LogTask, Display, TEXT("%s"), *At(Index).GetDebugString());
 	}
 }
 
 FString FGridPoint::GetDebugString() const
 {
-	const FString DebugString(TEXT("Index:{0}, X:{1}, Y:{2}, Actor:{3}"));
+	const FString DebugString(TEXT("Index:{0}, X:{1}, Y:{2}, Unit:{3}"));
 	return FString::Format(*DebugString, {
 		                       *FString::FromInt(Index),
 		                       *FString::FromInt(GridCoords.X),
 		                       *FString::FromInt(GridCoords.Y),
-		                       *GetNameSafe(GameActor)
+		                       *FString::FromInt(UnitId)
 	                       });
 }
 
-void FGrid::Init(int32 InSizeX, int32 InSizeY, EGridType InGridType)
+void FGrid::Init(int32 InSizeX, int32 InSizeY, EGridType InGridType, EGridCellOrdering InCellOrdering)
 {
 	SizeX = InSizeX;
 	SizeY = InSizeY;
 	GridType = InGridType;
-	//GridArray.Init(FGridPoint, SizeX * SizeY);
-	GridArray.SetNumZeroed(SizeX * SizeY);
+	CellOrdering = InCellOrdering;
+	UnitIds.Init(INDEX_NONE, SizeX * SizeY);
+	OccupancyVersions.Init(0, SizeX * SizeY);
+	TerrainCosts.Init(DefaultTerrainCost, SizeX * SizeY);
+	bUniformTerrain = true;
+	MinTerrainScale = 1.f;
+	MaxTerrainScale = 1.f;
+
+	// All the points start empty
+	EmptyIndices.SetNumUninitialized(Num());
+	EmptyPositions.SetNumUninitialized(Num());
+	for (int32 Index = 0; Index < Num(); ++Index)
+	{
+		EmptyIndices[Index] = Index;
+		EmptyPositions[Index] = Index;
+	}
+}
 
-	for (int Rows = 0; Rows < SizeY; ++Rows)
+void FGrid::SetTerrain(TConstArrayView<uint8> InTerrainCosts)
+{
+	checkf(InTerrainCosts.Num() == Num(), TEXT("[FGrid::SetTerrain] The terrain doesn't match the Grid size."));
+
+	bUniformTerrain = true;
+	uint8 MinTerrainCost = MAX_uint8;
+	uint8 MaxTerrainCost = 0;
+	for (int32 Y = 0; Y < SizeY; ++Y)
 	{
-		for (int Cols = 0; Cols < SizeX; ++Cols)
+		for (int32 X = 0; X < SizeX; ++X)
 		{
-			FGridPoint& GridPoint = GridArray[Cols + (Rows * SizeY)];
-			GridPoint.GridCoords = FIntPoint{Cols, Rows};
-			GridPoint.Index = Cols + (Rows * SizeY);
+			const uint8 TerrainCost = InTerrainCosts[X + Y * SizeX];
+			TerrainCosts[GetIndex(FIntPoint{X, Y})] = TerrainCost;
+			if (TerrainCost != BlockedTerrainCost)
+			{
+				bUniformTerrain &= TerrainCost == DefaultTerrainCost;
+				MinTerrainCost = FMath::Min(MinTerrainCost, TerrainCost);
+				MaxTerrainCost = FMath::Max(MaxTerrainCost, TerrainCost);
+			}
 		}
 	}
+	MinTerrainScale = bUniformTerrain ? 1.f : StaticCast<float>(MinTerrainCost) / DefaultTerrainCost;
+	MaxTerrainScale = bUniformTerrain ? 1.f : StaticCast<float>(MaxTerrainCost) / DefaultTerrainCost;
+
+	// The blocked points are never empty
+	EmptyIndices.Reset();
+	for (int32 Index = 0; Index < Num(); ++Index)
+	{
+		checkf(!IsBlocked(Index) || !IsOccupied(Index), TEXT("[FGrid::SetTerrain] A unit is on a blocked point."));
+		EmptyPositions[Index] = IsBlocked(Index) || IsOccupied(Index) ? INDEX_NONE : EmptyIndices.Add(Index);
+	}
 }
 
-const TArray<FGridPoint>& FGrid::GetGrid() const
+FGridPoint FGrid::At(int32 Index) const
 {
-	return GridArray;
+	checkf(UnitIds.IsValidIndex(Index), TEXT("[FGrid::At] Argument Index out of bounds."));
+
+	FGridPoint GridPoint;
+	GridPoint.GridCoords = GetCoordinates(Index);
+	GridPoint.UnitId = UnitIds[Index];
+	GridPoint.Index = Index;
+	return GridPoint;
 }
 
-FGridPoint& FGrid::At(int32 Index)
+FGridPoint FGrid::At(FIntPoint Coordinates) const
 {
-	checkf(Index < GridArray.Num(), TEXT("[FGrid::At] Argument Index out of bounds."));
-	return GridArray[Index];
+	const int32 Index = GetIndex(Coordinates);
+	checkf(UnitIds.IsValidIndex(Index), TEXT("[FGrid::At] Coordinates out of bounds."));
+
+	return At(Index);
 }
 
-FGridPoint& FGrid::At(FIntPoint Coordinates)
+void FGrid::SetUnitId(const FIntPoint& Coordinates, int32 InUnitId)
 {
-	//const int32 Index = Coordinates.X * Coordinates.Y;
-	const int32 Index = Coordinates.X + (Coordinates.Y * SizeY);
-	checkf(Index < GridArray.Num(), TEXT("[FGrid::At] Coordinates out of bounds."));
+	const int32 Index = GetIndex(Coordinates);
+	checkf(UnitIds.IsValidIndex(Index), TEXT("[FGrid::SetUnitId] Coordinates out of bounds."));
+	checkf(InUnitId == INDEX_NONE || !IsBlocked(Index), TEXT("[FGrid::SetUnitId] The point is blocked."));
+	TRACE_COUNTER_INCREMENT(GridWrites);
+
+	const bool bWasEmpty = UnitIds[Index] == INDEX_NONE;
+	const bool bIsEmpty = InUnitId == INDEX_NONE;
+	UnitIds[Index] = InUnitId;
+	if (bWasEmpty == bIsEmpty)
+	{
+		return;
+	}
 
-	return GridArray[Index];
+	++OccupancyVersions[Index];
+	if (bIsEmpty)
+	{
+		EmptyPositions[Index] = EmptyIndices.Add(Index);
+	}
+	else
+	{
+		// Swap the last empty point into the place of the occupied one
+		const int32 Position = EmptyPositions[Index];
+		const int32 LastIndex = EmptyIndices.Last();
+		EmptyIndices[Position] = LastIndex;
+		EmptyPositions[LastIndex] = Position;
+		EmptyIndices.Pop(false);
+		EmptyPositions[Index] = INDEX_NONE;
+	}
 }
 
-const FGridPoint& FGrid::At(FIntPoint Coordinates) const
+void FGrid::CopyOccupancy(const FGrid& InGrid)
 {
-	//const int32 Index = Coordinates.X * Coordinates.Y;
-	const int32 Index = Coordinates.X + (Coordinates.Y * SizeY);
-	checkf(Index < GridArray.Num(), TEXT("[FGrid::At] Coordinates out of bounds."));
+	checkf(InGrid.SizeX == SizeX && InGrid.SizeY == SizeY && InGrid.GridType == GridType
+	       && InGrid.CellOrdering == CellOrdering, TEXT("[FGrid::CopyOccupancy] The grids don't match."));
 
-	return GridArray[Index];
+	FMemory::Memcpy(UnitIds.GetData(), InGrid.UnitIds.GetData(), UnitIds.Num() * UnitIds.GetTypeSize());
+	FMemory::Memcpy(OccupancyVersions.GetData(), InGrid.OccupancyVersions.GetData(),
+	                OccupancyVersions.Num() * OccupancyVersions.GetTypeSize());
 }
 
-bool FGrid::FindRandomEmptyPointOnGrid(FGridPoint& OutGridPoint) const
+bool FGrid::FindRandomEmptyPointOnGrid(FSimulationRandomStream& InRandom, FGridPoint& OutGridPoint) const
 {
-	bool bResult = false;
-	if (EmptyPoints.Num() <= 0)
+	if (EmptyIndices.Num() == 0)
 	{
 		return false;
 	}
 
-	const auto RandomIndex = FMath::RandRange(0, EmptyPoints.Num() - 1);
-	OutGridPoint = EmptyPoints[RandomIndex];
-
-	if(GridArray[OutGridPoint.Index].GameActor != nullptr)
-	{
-		UE_LOG(LogTask, Display, TEXT("[AIT_GameModeDefault::FindRandomEmptyPointOnGrid] Cell is occupied."));
-	}
-	EmptyPoints.RemoveAt(RandomIndex);
+	OutGridPoint = At(EmptyIndices[InRandom.RandRange(0, EmptyIndices.Num() - 1)]);
 	return true;
-
-	/*int32 RandomIndex = INDEX_NONE;
-	const FGridPoint RandomPoint = FindRandomPointOnGrid(RandomIndex);
-
-	// If the GridPoint is not empty
-	if (RandomPoint.GameActor != nullptr)
-	{
-		// Go heavy, copy all empty slots into temp grid copy and get random there.
-		TArray<FGridPoint> TempGrid = GridArray;
-		for (auto& Point : GridArray)
-		{
-			if (Point.GameActor == nullptr)
-			{
-				TempGrid.Add(Point);
-			}
-		}
-		if (TempGrid.Num() > 0)
-		{
-			OutGridPoint = TempGrid[FMath::RandRange(0, TempGrid.Num() - 1)];
-			bResult = true;
-		}
-		else
-		{
-			// The whole grid is occupied? Most probably, some sort of a error
-			OutGridPoint = FGridPoint();
-		}
-	}
-	else
-	{
-		OutGridPoint = RandomPoint;
-		bResult = true;
-	}
-	
-	return bResult;*/
 }
 
-FGridPoint FGrid::FindRandomPointOnGrid(int32& OutRandomIndex) const
+FGridPoint FGrid::FindRandomPointOnGrid(FSimulationRandomStream& InRandom, int32& OutRandomIndex) const
 {
-	checkf(GridArray.Num() > 0, TEXT("[FGrid::FindRandomPointOnGrid] Operation on an empty grid."));
-	//OutRandomIndex = FMath::RandRange(0, GridArray.Num() - 1);
-	//return GridArray[OutRandomIndex];
-	OutRandomIndex = FMath::RandRange(0, EmptyPoints.Num() - 1);
-	return GridArray[OutRandomIndex];
+	checkf(Num() > 0, TEXT("[FGrid::FindRandomPointOnGrid] Operation on an empty grid."));
+	OutRandomIndex = InRandom.RandRange(0, Num() - 1);
+	return At(OutRandomIndex);
 }
 
 EGridType FGrid::GetGridType() const
 {
-	return EGridType::Rectangular;
+	return GridType;
 }
 
-TArray<FGridPoint> FGrid::GetNodeConnections(const FGridPoint& Point) const
+float FGrid::GetDistance(const FIntPoint& From, const FIntPoint& To) const
 {
-	TArray<FGridPoint> ResultPoints;
-
-	if (GridModifiersMapping.Contains(GridType))
+	switch (GridType)
+	{
+	case EGridType::Hexagonal:
 	{
-		for (auto& Modifier : GridModifiersMapping[GridType])
+		// Convert the "odd-r" offset coordinates into the axial ones, the third cube coordinate is -Q-R
+		auto ToAxial = [](const FIntPoint& Coordinates)
 		{
-			FIntPoint TargetPoint = Point.GridCoords + Modifier;
-			if (IsPointOnGrid(TargetPoint))
-			{
-				ResultPoints.Emplace(FGridPoint(At(TargetPoint)));
-			}
-		}
+			return FIntPoint{Coordinates.X - (Coordinates.Y - (Coordinates.Y & 1)) / 2, Coordinates.Y};
+		};
+		const FIntPoint Delta = ToAxial(To) - ToAxial(From);
+		return (FMath::Abs(Delta.X) + FMath::Abs(Delta.Y) + FMath::Abs(Delta.X + Delta.Y)) / 2;
+	}
+	case EGridType::Octagonal:
+	{
+		const int32 DeltaX = FMath::Abs(To.X - From.X);
+		const int32 DeltaY = FMath::Abs(To.Y - From.Y);
+		return FMath::Max(DeltaX, DeltaY) + (UE_SQRT_2 - 1.f) * FMath::Min(DeltaX, DeltaY);
+	}
+	default:
+		return FMath::Abs(To.X - From.X) + FMath::Abs(To.Y - From.Y);
 	}
-	return ResultPoints;
-}
-
-bool FGrid::IsPointOnGrid(const FIntPoint& Point) const
-{
-	return (Point.X >= 0 && Point.X < SizeX)
-		&& (Point.Y >= 0 && Point.Y < SizeY);
 }
 
-void FGrid::OnStartSpawningActors()
+FVector2D FGrid::GetLayoutPosition(EGridType InGridType, const FIntPoint& Coordinates)
 {
-	EmptyPoints = GridArray;
+	if (InGridType == EGridType::Hexagonal)
+	{
+		// The centers of the neighbor points in the adjacent rows are 1 point apart as well
+		static constexpr double RowSpacing = UE_DOUBLE_HALF_SQRT_3;
+		return FVector2D{Coordinates.X + ((Coordinates.Y & 1) ? 0.5 : 0.0), Coordinates.Y * RowSpacing};
+	}
+	return FVector2D{Coordinates};
 }
 
-void FGrid::OnFinishSpawningActors()
+bool FGrid::IsPointOnGrid(const FIntPoint& Point) const
 {
-	EmptyPoints.Empty();
+	return (Point.X >= 0 && Point.X < SizeX)
+		&& (Point.Y >= 0 && Point.Y < SizeY);
 }
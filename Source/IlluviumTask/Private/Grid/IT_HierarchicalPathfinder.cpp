@@ -0,0 +1,733 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Grid/IT_HierarchicalPathfinder.h"
+
+#include "Algo/Reverse.h"
+#include "Grid/IT_Grid.h"
+#include "Grid/IT_PathfinderDiagnostics.h"
+#include "IlluviumTask/IlluviumTask.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+
+// Shorter runs of the passable border points get a single entrance in the middle, longer ones get one at each end
+static constexpr int32 MinTwoEntrancesRunLength = 6;
+
+static constexpr float UnreachableCost = TNumericLimits<float>::Max();
+
+void IT_HierarchicalPathfinder::Init(const FGrid& InGrid, int32 InClusterSize)
+{
+	Grid = &InGrid;
+	ClusterSize = FMath::Max(InClusterSize, 2);
+	ClustersX = FMath::DivideAndRoundUp(InGrid.GetSizeX(), ClusterSize);
+	ClustersY = FMath::DivideAndRoundUp(InGrid.GetSizeY(), ClusterSize);
+
+	const int32 NumClusters = ClustersX * ClustersY;
+	Clusters.Reset();
+	Clusters.SetNum(NumClusters);
+	BordersX.Reset();
+	BordersX.SetNum(NumClusters);
+	BordersY.Reset();
+	BordersY.SetNum(NumClusters);
+	ClusterFirstNodes.Init(0, NumClusters);
+	NodeClusterIds.Reset();
+	EndNodeCosts.Reset();
+
+	for (int32 ClusterId = 0; ClusterId < NumClusters; ++ClusterId)
+	{
+		const FIntPoint Min{(ClusterId % ClustersX) * ClusterSize, (ClusterId / ClustersX) * ClusterSize};
+		const FIntPoint Max{
+			FMath::Min(Min.X + ClusterSize, InGrid.GetSizeX()), FMath::Min(Min.Y + ClusterSize, InGrid.GetSizeY())
+		};
+		Clusters[ClusterId].Bounds = FIntRect(Min, Max);
+	}
+
+	// Everything is built on the first query
+	DirtyClusters.Init(true, NumClusters);
+	DirtyClusterIds.Reset(NumClusters);
+	for (int32 ClusterId = 0; ClusterId < NumClusters; ++ClusterId)
+	{
+		DirtyClusterIds.Add(ClusterId);
+	}
+
+	// The searches may start and end on the ring around the cluster
+	Scratch.Init(FMath::Square(ClusterSize + 2));
+}
+
+void IT_HierarchicalPathfinder::MarkDirty(const FIntPoint& InCoordinates)
+{
+	const int32 ClusterId = GetClusterId(InCoordinates);
+	if (DirtyClusters.IsValidIndex(ClusterId) && !DirtyClusters[ClusterId])
+	{
+		DirtyClusters[ClusterId] = true;
+		DirtyClusterIds.Add(ClusterId);
+	}
+}
+
+float IT_HierarchicalPathfinder::GetCrossingSlack() const
+{
+	// A run shorter than MinTwoEntrancesRunLength has its entrance in the middle, a longer one at both ends
+	const int32 MaxEntranceDistance = FMath::Max((MinTwoEntrancesRunLength - 1) / 2, (ClusterSize - 1) / 2);
+	return (4 * MaxEntranceDistance + 2) * Grid->GetMaxTerrainScale();
+}
+
+float IT_HierarchicalPathfinder::GetCostBound(TConstArrayView<FIntPoint> InOptimalPath, float InOptimalCost) const
+{
+	// The first and the last steps are taken by the searches from the start and the end, they add nothing
+	int32 NumCrossings = 0;
+	for (int32 Point = 2; Point < InOptimalPath.Num() - 1; ++Point)
+	{
+		const FIntPoint& From = InOptimalPath[Point - 1];
+		const FIntPoint& To = InOptimalPath[Point];
+		if (GetClusterId(From) == GetClusterId(To))
+		{
+			continue;
+		}
+
+		// The common neighbors of the diagonal neighbors on both topologies are the points that take the X of one and
+		// the Y of the other. Without a walkable one the crossing is an entrance itself
+		const bool bIsStraight = From.X == To.X || From.Y == To.Y;
+		if (bIsStraight || IsWalkable(FIntPoint{To.X, From.Y}) || IsWalkable(FIntPoint{From.X, To.Y}))
+		{
+			++NumCrossings;
+		}
+	}
+	return InOptimalCost + NumCrossings * GetCrossingSlack();
+}
+
+SIZE_T IT_HierarchicalPathfinder::GetAllocatedSize() const
+{
+	SIZE_T Size = Clusters.GetAllocatedSize() + BordersX.GetAllocatedSize() + BordersY.GetAllocatedSize()
+		+ DirtyClusterIds.GetAllocatedSize() + DirtyClusters.GetAllocatedSize() + ClusterFirstNodes.GetAllocatedSize()
+		+ NodeClusterIds.GetAllocatedSize() + Scratch.GetAllocatedSize() + AbstractScratch.GetAllocatedSize()
+		+ StartEdges.GetAllocatedSize() + EndEdges.GetAllocatedSize() + EndNodeCosts.GetAllocatedSize()
+		+ Waypoints.GetAllocatedSize();
+	for (int32 ClusterId = 0; ClusterId < Clusters.Num(); ++ClusterId)
+	{
+		const FCluster& Cluster = Clusters[ClusterId];
+		Size += Cluster.EntranceIndices.GetAllocatedSize() + Cluster.Distances.GetAllocatedSize()
+			+ BordersX[ClusterId].GetAllocatedSize() + BordersY[ClusterId].GetAllocatedSize();
+	}
+	return Size;
+}
+
+int32 IT_HierarchicalPathfinder::GetClusterId(const FIntPoint& InCoordinates) const
+{
+	return InCoordinates.X / ClusterSize + (InCoordinates.Y / ClusterSize) * ClustersX;
+}
+
+bool IT_HierarchicalPathfinder::IsWalkable(const FIntPoint& InCoordinates) const
+{
+	return Grid->IsPointOnGrid(InCoordinates) && !Grid->IsOccupied(InCoordinates) && !Grid->IsBlocked(InCoordinates);
+}
+
+template <typename FVisitor>
+void IT_HierarchicalPathfinder::ForEachEntrance(int32 InClusterId, FVisitor&& Visitor)
+{
+	const int32 ClusterX = InClusterId % ClustersX;
+	const int32 ClusterY = InClusterId / ClustersX;
+
+	for (TArray<FEntrance>* Border : {&BordersX[InClusterId], &BordersY[InClusterId]})
+	{
+		for (FEntrance& Entrance : *Border)
+		{
+			Visitor(Entrance, true, Entrance.NeighborClusterId);
+		}
+	}
+
+	// The borders of the previous clusters reach into this one, the X ones also diagonally
+	auto VisitIncoming = [InClusterId, &Visitor](TArray<FEntrance>& Border, int32 OtherClusterId)
+	{
+		for (FEntrance& Entrance : Border)
+		{
+			if (Entrance.NeighborClusterId == InClusterId)
+			{
+				Visitor(Entrance, false, OtherClusterId);
+			}
+		}
+	};
+	if (ClusterX > 0)
+	{
+		for (int32 OtherY = FMath::Max(ClusterY - 1, 0); OtherY <= FMath::Min(ClusterY + 1, ClustersY - 1); ++OtherY)
+		{
+			const int32 OtherClusterId = ClusterX - 1 + OtherY * ClustersX;
+			VisitIncoming(BordersX[OtherClusterId], OtherClusterId);
+		}
+	}
+	if (ClusterY > 0)
+	{
+		VisitIncoming(BordersY[InClusterId - ClustersX], InClusterId - ClustersX);
+	}
+}
+
+void IT_HierarchicalPathfinder::GetHomeClusters(const FIntPoint& InCoordinates, FHomeClusterIds& OutClusterIds) const
+{
+	OutClusterIds.Reset();
+	OutClusterIds.Add(GetClusterId(InCoordinates));
+	Grid->ForEachNeighbor(InCoordinates, [this, &OutClusterIds](const FGridNeighbor& Neighbor)
+	{
+		OutClusterIds.AddUnique(GetClusterId(Neighbor.Coordinates));
+	});
+}
+
+void IT_HierarchicalPathfinder::ConnectToEntrances(int32 InIndex, const FHomeClusterIds& InHomeClusterIds,
+                                                   TArray<FQueryEdge>& OutEdges)
+{
+	for (const int32 ClusterId : InHomeClusterIds)
+	{
+		const FCluster& Cluster = Clusters[ClusterId];
+		if (Cluster.EntranceIndices.Num() == 0)
+		{
+			continue;
+		}
+
+		SearchBounded(Cluster.Bounds, InIndex, INDEX_NONE);
+		for (int32 Entrance = 0; Entrance < Cluster.EntranceIndices.Num(); ++Entrance)
+		{
+			const float Cost = GetBoundedCost(Cluster.Bounds, Cluster.EntranceIndices[Entrance]);
+			if (Cost != UnreachableCost)
+			{
+				OutEdges.Add(FQueryEdge{ClusterFirstNodes[ClusterId] + Entrance, Cost});
+			}
+		}
+	}
+}
+
+TArray<Path::FNode> IT_HierarchicalPathfinder::FindPath(const Path::FNode& InStartNode, const Path::FNode& InEndNode)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IT_FindHierarchicalPath);
+	TArray<Path::FNode> ResultNodes;
+
+	const FIntPoint& Start = InStartNode.XY;
+	const FIntPoint& End = InEndNode.XY;
+	if (Grid == nullptr || !Grid->IsPointOnGrid(Start) || !Grid->IsPointOnGrid(End))
+	{
+		UE_LOG(LogTask, Warning, TEXT("[IT_HierarchicalPathfinder::FindPath] Invalid query."));
+		return ResultNodes;
+	}
+
+	RebuildDirtyClusters();
+
+	const int32 StartClusterId = GetClusterId(Start);
+	if (StartClusterId == GetClusterId(End))
+	{
+		// The path inside the cluster is the shortest one, unless a path leaving the cluster may be shorter
+		const FIntRect& Bounds = Clusters[StartClusterId].Bounds;
+		const int32 EndIndex = Grid->GetIndex(End);
+		if (SearchBounded(Bounds, Grid->GetIndex(Start), EndIndex)
+			&& GetBoundedCost(Bounds, EndIndex) <= GetLeavingCostEstimate(Bounds, Start, End))
+		{
+			ResultNodes.Add(Path::FNode{Start, true});
+			AppendBoundedPath(Bounds, Start, End, ResultNodes);
+			return ResultNodes;
+		}
+	}
+
+	// The abstract graph is complete, without a path on it there is none
+	if (!FindAbstractPath(Start, End))
+	{
+		return ResultNodes;
+	}
+
+	ResultNodes.Add(Path::FNode{Start, true});
+	for (int32 Waypoint = 1; Waypoint < Waypoints.Num(); ++Waypoint)
+	{
+		const FIntPoint& From = Waypoints[Waypoint - 1].Coordinates;
+		if (!RefineSegment(From, Waypoints[Waypoint], ResultNodes))
+		{
+			UE_LOG(LogTask, Warning, TEXT("[IT_HierarchicalPathfinder::FindPath] Failed to refine %s - %s."),
+			       *From.ToString(), *Waypoints[Waypoint].Coordinates.ToString());
+			ResultNodes.Reset();
+			break;
+		}
+	}
+	return ResultNodes;
+}
+
+bool IT_HierarchicalPathfinder::FindAbstractPath(const FIntPoint& InStart, const FIntPoint& InEnd)
+{
+	Waypoints.Reset();
+
+	const int32 StartIndex = Grid->GetIndex(InStart);
+	const int32 EndIndex = Grid->GetIndex(InEnd);
+
+	// Connect the start and the end to the entrances of the clusters they may step into first
+	FHomeClusterIds StartHomeClusterIds;
+	FHomeClusterIds EndHomeClusterIds;
+	GetHomeClusters(InStart, StartHomeClusterIds);
+	GetHomeClusters(InEnd, EndHomeClusterIds);
+
+	StartEdges.Reset();
+	ConnectToEntrances(StartIndex, StartHomeClusterIds, StartEdges);
+	EndEdges.Reset();
+	ConnectToEntrances(EndIndex, EndHomeClusterIds, EndEdges);
+	for (const FQueryEdge& Edge : EndEdges)
+	{
+		EndNodeCosts[Edge.Node] = Edge.Cost;
+	}
+
+	// A cluster both of them step into may connect them directly
+	float DirectCost = UnreachableCost;
+	int32 DirectClusterId = INDEX_NONE;
+	for (const int32 ClusterId : StartHomeClusterIds)
+	{
+		const FIntRect& Bounds = Clusters[ClusterId].Bounds;
+		if (EndHomeClusterIds.Contains(ClusterId) && SearchBounded(Bounds, StartIndex, EndIndex)
+			&& GetBoundedCost(Bounds, EndIndex) < DirectCost)
+		{
+			DirectCost = GetBoundedCost(Bounds, EndIndex);
+			DirectClusterId = ClusterId;
+		}
+	}
+
+	// A* over the abstract graph. The entrances are its nodes, the start and the end follow them
+	const int32 NumNodes = NodeClusterIds.Num();
+	const int32 StartNode = NumNodes;
+	const int32 EndNode = NumNodes + 1;
+	if (AbstractScratch.Num() < NumNodes + 2)
+	{
+		// With some slack, as the number of the entrances changes with the occupancy
+		AbstractScratch.Init(StaticCast<int32>(FMath::RoundUpToPowerOfTwo(NumNodes + 2)));
+	}
+	AbstractScratch.Reset();
+
+	auto GetNodeIndex = [&](int32 InNode)
+	{
+		if (InNode >= NumNodes)
+		{
+			return InNode == StartNode ? StartIndex : EndIndex;
+		}
+		const int32 ClusterId = NodeClusterIds[InNode];
+		return Clusters[ClusterId].EntranceIndices[InNode - ClusterFirstNodes[ClusterId]];
+	};
+	auto Relax = [&](int32 InNode, float InCostSoFar, int32 InParentNode)
+	{
+		if (!AbstractScratch.ClosedSet[InNode])
+		{
+			AbstractScratch.Relax(InNode, InCostSoFar, InParentNode,
+			                      Grid->GetCostEstimate(Grid->GetCoordinates(GetNodeIndex(InNode)), InEnd));
+		}
+	};
+
+	Relax(StartNode, 0.f, INDEX_NONE);
+
+	bool bPathFound = false;
+	while (!AbstractScratch.OpenList.IsEmpty())
+	{
+		const int32 Node = AbstractScratch.OpenList.Pop();
+		AbstractScratch.ClosedSet[Node] = true;
+		const float CostSoFar = AbstractScratch.CostSoFar[Node];
+
+		if (Node == EndNode)
+		{
+			bPathFound = true;
+			break;
+		}
+
+		if (Node == StartNode)
+		{
+			for (const FQueryEdge& Edge : StartEdges)
+			{
+				Relax(Edge.Node, CostSoFar + Edge.Cost, Node);
+			}
+			if (DirectClusterId != INDEX_NONE)
+			{
+				Relax(EndNode, CostSoFar + DirectCost, Node);
+			}
+			continue;
+		}
+
+		// An entrance: the other entrances of its cluster, the entrances across the borders and the end
+		const int32 ClusterId = NodeClusterIds[Node];
+		const FCluster& Cluster = Clusters[ClusterId];
+		const int32 FirstNode = ClusterFirstNodes[ClusterId];
+		const int32 NumEntrances = Cluster.EntranceIndices.Num();
+		const int32 Entrance = Node - FirstNode;
+
+		for (int32 OtherEntrance = 0; OtherEntrance < NumEntrances; ++OtherEntrance)
+		{
+			const float Distance = Cluster.Distances[Entrance * NumEntrances + OtherEntrance];
+			if (OtherEntrance != Entrance && Distance != UnreachableCost)
+			{
+				Relax(FirstNode + OtherEntrance, CostSoFar + Distance, Node);
+			}
+		}
+
+		ForEachEntrance(ClusterId, [&](const FEntrance& BorderEntrance, bool bIsOwnBorder, int32 OtherClusterId)
+		{
+			if ((bIsOwnBorder ? BorderEntrance.Slot : BorderEntrance.NeighborSlot) == Entrance)
+			{
+				const int32 OtherSlot = bIsOwnBorder ? BorderEntrance.NeighborSlot : BorderEntrance.Slot;
+				Relax(ClusterFirstNodes[OtherClusterId] + OtherSlot, CostSoFar + BorderEntrance.Cost, Node);
+			}
+		});
+
+		if (EndNodeCosts[Node] != UnreachableCost)
+		{
+			Relax(EndNode, CostSoFar + EndNodeCosts[Node], Node);
+		}
+	}
+
+	for (const FQueryEdge& Edge : EndEdges)
+	{
+		EndNodeCosts[Edge.Node] = UnreachableCost;
+	}
+
+	if (!bPathFound)
+	{
+		IT_PATH_TRACE(TEXT("[IT_HierarchicalPathfinder] No abstract path from %s to %s"), *InStart.ToString(),
+		              *InEnd.ToString());
+		return false;
+	}
+
+	// The segments to the end are searched in the cluster of the edge, the ones between the entrances of different
+	// clusters are single steps
+	for (int32 Node = EndNode; Node != INDEX_NONE; Node = AbstractScratch.ParentIndices[Node])
+	{
+		const int32 ParentNode = AbstractScratch.ParentIndices[Node];
+		int32 SegmentClusterId = INDEX_NONE;
+		if (Node == EndNode)
+		{
+			SegmentClusterId = ParentNode == StartNode ? DirectClusterId : NodeClusterIds[ParentNode];
+		}
+		else if (ParentNode == StartNode
+			|| (ParentNode != INDEX_NONE && NodeClusterIds[ParentNode] == NodeClusterIds[Node]))
+		{
+			SegmentClusterId = NodeClusterIds[Node];
+		}
+		Waypoints.Add(FWaypoint{Grid->GetCoordinates(GetNodeIndex(Node)), SegmentClusterId});
+	}
+	Algo::Reverse(Waypoints);
+	return true;
+}
+
+bool IT_HierarchicalPathfinder::RefineSegment(const FIntPoint& InFrom, const FWaypoint& InTo,
+                                              TArray<Path::FNode>& OutPath)
+{
+	if (InTo.ClusterId == INDEX_NONE)
+	{
+		// The entrances of different clusters are neighbors
+		OutPath.Add(Path::FNode{InTo.Coordinates, true});
+		return true;
+	}
+
+	const FIntRect& Bounds = Clusters[InTo.ClusterId].Bounds;
+	if (!SearchBounded(Bounds, Grid->GetIndex(InFrom), Grid->GetIndex(InTo.Coordinates)))
+	{
+		return false;
+	}
+
+	AppendBoundedPath(Bounds, InFrom, InTo.Coordinates, OutPath);
+	return true;
+}
+
+void IT_HierarchicalPathfinder::AppendBoundedPath(const FIntRect& InBounds, const FIntPoint& InFrom,
+                                                  const FIntPoint& InTo, TArray<Path::FNode>& OutPath) const
+{
+	const int32 FirstNewNode = OutPath.Num();
+	const int32 FromLocalIndex = ToLocalIndex(InBounds, InFrom);
+	for (int32 LocalIndex = ToLocalIndex(InBounds, InTo); LocalIndex != FromLocalIndex;
+	     LocalIndex = Scratch.ParentIndices[LocalIndex])
+	{
+		OutPath.Add(Path::FNode{ToCoordinates(InBounds, LocalIndex), true});
+	}
+	Algo::Reverse(OutPath.GetData() + FirstNewNode, OutPath.Num() - FirstNewNode);
+}
+
+float IT_HierarchicalPathfinder::GetLeavingCostEstimate(const FIntRect& InBounds, const FIntPoint& InStart,
+                                                        const FIntPoint& InEnd) const
+{
+	// Such a path passes a point of the ring around the bounds, the neighbors of the bounds on every topology
+	float MinCost = UnreachableCost;
+	auto VisitRingPoint = [this, &InStart, &InEnd, &MinCost](const FIntPoint& InCoordinates)
+	{
+		if (IsWalkable(InCoordinates))
+		{
+			MinCost = FMath::Min(MinCost, Grid->GetCostEstimate(InStart, InCoordinates)
+			                     + Grid->GetCostEstimate(InCoordinates, InEnd));
+		}
+	};
+
+	for (int32 X = InBounds.Min.X - 1; X <= InBounds.Max.X; ++X)
+	{
+		VisitRingPoint(FIntPoint{X, InBounds.Min.Y - 1});
+		VisitRingPoint(FIntPoint{X, InBounds.Max.Y});
+	}
+	for (int32 Y = InBounds.Min.Y; Y < InBounds.Max.Y; ++Y)
+	{
+		VisitRingPoint(FIntPoint{InBounds.Min.X - 1, Y});
+		VisitRingPoint(FIntPoint{InBounds.Max.X, Y});
+	}
+	return MinCost;
+}
+
+void IT_HierarchicalPathfinder::RebuildDirtyClusters()
+{
+	if (DirtyClusterIds.Num() == 0)
+	{
+		return;
+	}
+
+	// Every cluster with an entrance on a placed border renumbers its entrances
+	TBitArray<> AffectedClusters(false, Clusters.Num());
+	TArray<int32> AffectedClusterIds;
+	auto AddAffected = [&](int32 InClusterId)
+	{
+		if (!AffectedClusters[InClusterId])
+		{
+			AffectedClusters[InClusterId] = true;
+			AffectedClusterIds.Add(InClusterId);
+		}
+	};
+
+	TBitArray<> PlacedBordersX(false, Clusters.Num());
+	TBitArray<> PlacedBordersY(false, Clusters.Num());
+	auto PlaceBorder = [&](int32 InClusterX, int32 InClusterY, const FIntPoint& InDirection)
+	{
+		const int32 ClusterId = InClusterX + InClusterY * ClustersX;
+		TBitArray<>& PlacedBorders = InDirection.X != 0 ? PlacedBordersX : PlacedBordersY;
+		if (InClusterX < 0 || InClusterX >= ClustersX || InClusterY < 0 || InClusterY >= ClustersY
+			|| PlacedBorders[ClusterId])
+		{
+			return;
+		}
+		PlacedBorders[ClusterId] = true;
+
+		const TArray<FEntrance>& Border = InDirection.X != 0 ? BordersX[ClusterId] : BordersY[ClusterId];
+		for (const FEntrance& Entrance : Border)
+		{
+			AddAffected(Entrance.NeighborClusterId);
+		}
+		RebuildBorder(ClusterId, InDirection);
+		for (const FEntrance& Entrance : Border)
+		{
+			AddAffected(Entrance.NeighborClusterId);
+		}
+		AddAffected(ClusterId);
+	};
+
+	// The borders with a crossing of a dirty cluster's point are placed again. So are the X borders of the clusters
+	// above and below, the common neighbors of their diagonal crossings may be in the dirty cluster
+	for (const int32 ClusterId : DirtyClusterIds)
+	{
+		const int32 ClusterX = ClusterId % ClustersX;
+		const int32 ClusterY = ClusterId / ClustersX;
+
+		AddAffected(ClusterId);
+		for (int32 OtherY = ClusterY - 1; OtherY <= ClusterY + 1; ++OtherY)
+		{
+			PlaceBorder(ClusterX, OtherY, FIntPoint{1, 0});
+			PlaceBorder(ClusterX - 1, OtherY, FIntPoint{1, 0});
+		}
+		PlaceBorder(ClusterX, ClusterY, FIntPoint{0, 1});
+		PlaceBorder(ClusterX, ClusterY - 1, FIntPoint{0, 1});
+		DirtyClusters[ClusterId] = false;
+	}
+	DirtyClusterIds.Reset();
+
+	for (const int32 ClusterId : AffectedClusterIds)
+	{
+		RebuildCluster(ClusterId);
+	}
+	NumberAbstractNodes();
+
+	IT_PATH_TRACE(TEXT("[IT_HierarchicalPathfinder] Rebuilt %d clusters"), AffectedClusterIds.Num());
+}
+
+void IT_HierarchicalPathfinder::RebuildBorder(int32 InClusterId, const FIntPoint& InDirection)
+{
+	TArray<FEntrance>& Border = InDirection.X != 0 ? BordersX[InClusterId] : BordersY[InClusterId];
+	Border.Reset();
+
+	const FIntRect& Bounds = Clusters[InClusterId].Bounds;
+	const bool bAlongY = InDirection.X != 0;
+	if ((bAlongY && Bounds.Max.X >= Grid->GetSizeX()) || (!bAlongY && Bounds.Max.Y >= Grid->GetSizeY()))
+	{
+		return;
+	}
+
+	// Walk along the last row or column of the cluster, the neighbor cluster's points are one step in the direction
+	const FIntPoint First = bAlongY
+		                        ? FIntPoint{Bounds.Max.X - 1, Bounds.Min.Y}
+		                        : FIntPoint{Bounds.Min.X, Bounds.Max.Y - 1};
+	const FIntPoint Step = bAlongY ? FIntPoint{0, 1} : FIntPoint{1, 0};
+	const int32 Length = bAlongY ? Bounds.Height() : Bounds.Width();
+	const int32 NeighborClusterId = InClusterId + (bAlongY ? 1 : ClustersX);
+
+	auto AddEntrance = [this, &Border, &First, &Step, &InDirection, NeighborClusterId](int32 InPosition)
+	{
+		const FIntPoint Coordinates = First + Step * InPosition;
+		const int32 Index = Grid->GetIndex(Coordinates);
+		const int32 NeighborIndex = Grid->GetIndex(Coordinates + InDirection);
+		// The straight neighbors cost 1 on every grid type before the terrain
+		Border.Add(FEntrance{Index, NeighborIndex, NeighborClusterId, Grid->GetConnectionScale(Index, NeighborIndex)});
+	};
+
+	int32 RunStart = INDEX_NONE;
+	for (int32 Position = 0; Position <= Length; ++Position)
+	{
+		const FIntPoint Coordinates = First + Step * Position;
+		const bool bIsPassable = Position < Length
+			&& !Grid->IsOccupied(Coordinates) && !Grid->IsOccupied(Coordinates + InDirection)
+			&& !Grid->IsBlocked(Coordinates) && !Grid->IsBlocked(Coordinates + InDirection);
+
+		if (bIsPassable && RunStart == INDEX_NONE)
+		{
+			RunStart = Position;
+		}
+		else if (!bIsPassable && RunStart != INDEX_NONE)
+		{
+			const int32 RunLength = Position - RunStart;
+			if (RunLength < MinTwoEntrancesRunLength)
+			{
+				AddEntrance(RunStart + RunLength / 2);
+			}
+			else
+			{
+				AddEntrance(RunStart);
+				AddEntrance(Position - 1);
+			}
+			RunStart = INDEX_NONE;
+		}
+	}
+
+	// The diagonal neighbors across the border with no walkable common neighbor to step through. The ones crossing
+	// both an X and a Y border are placed with the X one
+	for (int32 Position = 0; Position < Length; ++Position)
+	{
+		const FIntPoint Coordinates = First + Step * Position;
+		if (!IsWalkable(Coordinates))
+		{
+			continue;
+		}
+
+		Grid->ForEachNeighbor(Coordinates, [&](const FGridNeighbor& Neighbor)
+		{
+			const FIntPoint& NeighborCoordinates = Neighbor.Coordinates;
+			const bool bIsDiagonal = NeighborCoordinates.X != Coordinates.X && NeighborCoordinates.Y != Coordinates.Y;
+			const bool bIsAcross = bAlongY
+				                       ? NeighborCoordinates.X > Coordinates.X
+				                       : NeighborCoordinates.Y > Coordinates.Y
+				                       && Bounds.Min.X <= NeighborCoordinates.X && NeighborCoordinates.X < Bounds.Max.X;
+			if (bIsDiagonal && bIsAcross && !Grid->IsOccupied(Neighbor.Index)
+				&& !IsWalkable(FIntPoint{NeighborCoordinates.X, Coordinates.Y})
+				&& !IsWalkable(FIntPoint{Coordinates.X, NeighborCoordinates.Y}))
+			{
+				Border.Add(FEntrance{
+					Grid->GetIndex(Coordinates), Neighbor.Index, GetClusterId(NeighborCoordinates), Neighbor.Cost
+				});
+			}
+		});
+	}
+}
+
+void IT_HierarchicalPathfinder::RebuildCluster(int32 InClusterId)
+{
+	FCluster& Cluster = Clusters[InClusterId];
+
+	// A point may be on several entrances, it is a single node
+	Cluster.EntranceIndices.Reset();
+	ForEachEntrance(InClusterId, [&Cluster](FEntrance& Entrance, bool bIsOwnBorder, int32)
+	{
+		if (bIsOwnBorder)
+		{
+			Entrance.Slot = Cluster.EntranceIndices.AddUnique(Entrance.Index);
+		}
+		else
+		{
+			Entrance.NeighborSlot = Cluster.EntranceIndices.AddUnique(Entrance.NeighborIndex);
+		}
+	});
+
+	const int32 NumEntrances = Cluster.EntranceIndices.Num();
+	Cluster.Distances.Init(UnreachableCost, NumEntrances * NumEntrances);
+	for (int32 Entrance = 0; Entrance < NumEntrances; ++Entrance)
+	{
+		Cluster.Distances[Entrance * NumEntrances + Entrance] = 0.f;
+
+		SearchBounded(Cluster.Bounds, Cluster.EntranceIndices[Entrance], INDEX_NONE);
+		for (int32 OtherEntrance = Entrance + 1; OtherEntrance < NumEntrances; ++OtherEntrance)
+		{
+			const float Distance = GetBoundedCost(Cluster.Bounds, Cluster.EntranceIndices[OtherEntrance]);
+			Cluster.Distances[Entrance * NumEntrances + OtherEntrance] = Distance;
+			Cluster.Distances[OtherEntrance * NumEntrances + Entrance] = Distance;
+		}
+	}
+}
+
+void IT_HierarchicalPathfinder::NumberAbstractNodes()
+{
+	NodeClusterIds.Reset();
+	for (int32 ClusterId = 0; ClusterId < Clusters.Num(); ++ClusterId)
+	{
+		ClusterFirstNodes[ClusterId] = NodeClusterIds.Num();
+		for (int32 Entrance = 0; Entrance < Clusters[ClusterId].EntranceIndices.Num(); ++Entrance)
+		{
+			NodeClusterIds.Add(ClusterId);
+		}
+	}
+	EndNodeCosts.Init(UnreachableCost, NodeClusterIds.Num());
+}
+
+bool IT_HierarchicalPathfinder::SearchBounded(const FIntRect& InBounds, int32 InStartIndex, int32 InGoalIndex)
+{
+	Scratch.Reset();
+
+	const FIntPoint GoalCoordinates = InGoalIndex != INDEX_NONE ? Grid->GetCoordinates(InGoalIndex) : FIntPoint();
+	auto Estimate = [this, InGoalIndex, &GoalCoordinates](const FIntPoint& InCoordinates)
+	{
+		return InGoalIndex != INDEX_NONE ? Grid->GetCostEstimate(InCoordinates, GoalCoordinates) : 0.f;
+	};
+
+	const FIntPoint StartCoordinates = Grid->GetCoordinates(InStartIndex);
+	Scratch.Relax(ToLocalIndex(InBounds, StartCoordinates), 0.f, INDEX_NONE, Estimate(StartCoordinates));
+
+	const int32 GoalLocalIndex = InGoalIndex != INDEX_NONE ? ToLocalIndex(InBounds, GoalCoordinates) : INDEX_NONE;
+	while (!Scratch.OpenList.IsEmpty())
+	{
+		const int32 CurrentLocalIndex = Scratch.OpenList.Pop();
+		Scratch.ClosedSet[CurrentLocalIndex] = true;
+
+		if (CurrentLocalIndex == GoalLocalIndex)
+		{
+			return true;
+		}
+
+		const FIntPoint CurrentCoordinates = ToCoordinates(InBounds, CurrentLocalIndex);
+		Grid->ForEachNeighbor(CurrentCoordinates, [&](const FGridNeighbor& Neighbor)
+		{
+			if (Neighbor.Index != InGoalIndex
+				&& (!InBounds.Contains(Neighbor.Coordinates) || Grid->IsOccupied(Neighbor.Index)))
+			{
+				return;
+			}
+
+			const int32 NeighborLocalIndex = ToLocalIndex(InBounds, Neighbor.Coordinates);
+			if (Scratch.ClosedSet[NeighborLocalIndex])
+			{
+				return;
+			}
+
+			Scratch.Relax(NeighborLocalIndex, Scratch.CostSoFar[CurrentLocalIndex] + Neighbor.Cost,
+			              CurrentLocalIndex, Estimate(Neighbor.Coordinates));
+		});
+	}
+	return false;
+}
+
+float IT_HierarchicalPathfinder::GetBoundedCost(const FIntRect& InBounds, int32 InIndex) const
+{
+	const int32 LocalIndex = ToLocalIndex(InBounds, Grid->GetCoordinates(InIndex));
+	return Scratch.IsDiscovered(LocalIndex) ? Scratch.CostSoFar[LocalIndex] : UnreachableCost;
+}
+
+int32 IT_HierarchicalPathfinder::ToLocalIndex(const FIntRect& InBounds, const FIntPoint& InCoordinates) const
+{
+	// Shifted by one for the ring around the bounds
+	return (InCoordinates.X - InBounds.Min.X + 1) + (InCoordinates.Y - InBounds.Min.Y + 1) * (ClusterSize + 2);
+}
+
+FIntPoint IT_HierarchicalPathfinder::ToCoordinates(const FIntRect& InBounds, int32 InLocalIndex) const
+{
+	return InBounds.Min + FIntPoint{InLocalIndex % (ClusterSize + 2) - 1, InLocalIndex / (ClusterSize + 2) - 1};
+}
@@ -0,0 +1,209 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Grid/IT_PathCache.h"
+
+#include "Grid/IT_Grid.h"
+
+void IT_PathCache::Init(int32 InNumUnits, int32 InRegionSize)
+{
+	Entries.Reset();
+	Entries.SetNum(InNumUnits);
+	RegionSize = FMath::Max(InRegionSize, 1);
+
+	NumHits = 0;
+	NumRepairs = 0;
+	NumMisses = 0;
+}
+
+bool IT_PathCache::FindCachedStep(int32 InUnitId, const FIntPoint& InStart, const FIntPoint& InGoal,
+                                  const FGrid& InGrid, FIntPoint& OutNextStep, FIntPoint& OutSearchFrom)
+{
+	FEntry& Entry = GetEntry(InUnitId);
+
+	const int32 RepairFrom = ValidatePath(Entry, InStart, InGoal, InGrid);
+	OutSearchFrom = RepairFrom != INDEX_NONE ? Entry.Points[RepairFrom] : FIntPoint::NoneValue;
+
+	// Only the points up to the repaired one are known to be valid
+	const int32 LastValidPoint = RepairFrom != INDEX_NONE ? RepairFrom : Entry.Points.Num() - 1;
+	if (Entry.Cursor >= LastValidPoint)
+	{
+		return false;
+	}
+
+	OutNextStep = Entry.Points[Entry.Cursor + 1];
+	return true;
+}
+
+void IT_PathCache::ApplySuffix(int32 InUnitId, TConstArrayView<FIntPoint> InPoints,
+                               TConstArrayView<uint32> InVersions)
+{
+	if (InPoints.Num() == 0)
+	{
+		return;
+	}
+
+	FEntry& Entry = GetEntry(InUnitId);
+	for (int32 Point = FMath::Max(Entry.Cursor, 0); Point < Entry.Points.Num(); ++Point)
+	{
+		if (Entry.Points[Point] == InPoints[0])
+		{
+			SpliceSuffix(Entry, Point, InPoints, InVersions);
+			return;
+		}
+	}
+
+	// The unit has left the path while the suffix was searched. The new path is followed if the unit gets on it
+	SpliceSuffix(Entry, INDEX_NONE, InPoints, InVersions);
+	Entry.Cursor = 0;
+}
+
+bool IT_PathCache::GetNextStep(int32 InUnitId, FIntPoint& OutNextStep) const
+{
+	if (!Entries.IsValidIndex(InUnitId) || !Entries[InUnitId].Points.IsValidIndex(Entries[InUnitId].Cursor + 1))
+	{
+		return false;
+	}
+
+	OutNextStep = Entries[InUnitId].Points[Entries[InUnitId].Cursor + 1];
+	return true;
+}
+
+void IT_PathCache::Invalidate(int32 InUnitId)
+{
+	if (Entries.IsValidIndex(InUnitId))
+	{
+		Entries[InUnitId] = FEntry();
+	}
+}
+
+SIZE_T IT_PathCache::GetAllocatedSize() const
+{
+	SIZE_T Size = Entries.GetAllocatedSize();
+	for (const FEntry& Entry : Entries)
+	{
+		Size += Entry.Points.GetAllocatedSize() + Entry.Versions.GetAllocatedSize();
+	}
+	return Size;
+}
+
+IT_PathCache::FEntry& IT_PathCache::GetEntry(int32 InUnitId)
+{
+	if (InUnitId >= Entries.Num())
+	{
+		Entries.SetNum(InUnitId + 1);
+	}
+	return Entries[InUnitId];
+}
+
+int32 IT_PathCache::ValidatePath(FEntry& InEntry, const FIntPoint& InStart, const FIntPoint& InGoal,
+                                 const FGrid& InGrid)
+{
+	// Follow the unit along its path. It stays where it was if it has lost its move, and it may have stepped onto
+	// the path further on while following another one
+	int32 UnitPoint = INDEX_NONE;
+	for (int32 Point = FMath::Max(InEntry.Cursor, 0); Point < InEntry.Points.Num(); ++Point)
+	{
+		if (InEntry.Points[Point] == InStart)
+		{
+			UnitPoint = Point;
+			break;
+		}
+	}
+
+	const bool bIsGoalInRegion = InEntry.Points.Num() > 0 && GetRegion(InEntry.Points.Last()) == GetRegion(InGoal);
+	if (UnitPoint == INDEX_NONE && bIsGoalInRegion)
+	{
+		UnitPoint = RejoinPath(InEntry, InStart, InGrid);
+	}
+
+	if (UnitPoint == INDEX_NONE || !bIsGoalInRegion)
+	{
+		++NumMisses;
+
+		InEntry.Points.Reset();
+		InEntry.Versions.Reset();
+		InEntry.Points.Add(InStart);
+		InEntry.Versions.Add(InGrid.GetOccupancyVersion(InGrid.GetIndex(InStart)));
+		InEntry.Cursor = 0;
+		return 0;
+	}
+	InEntry.Cursor = UnitPoint;
+
+	// Look for the first point that got occupied since it was seen empty. The goal is occupied by the target
+	int32 RepairFrom = INDEX_NONE;
+	const int32 LastPoint = InEntry.Points.Num() - 1;
+	for (int32 Point = InEntry.Cursor + 1; Point < LastPoint; ++Point)
+	{
+		const int32 Index = InGrid.GetIndex(InEntry.Points[Point]);
+		const uint32 Version = InGrid.GetOccupancyVersion(Index);
+		if (InEntry.Versions[Point] == Version)
+		{
+			continue;
+		}
+		if (InGrid.IsOccupied(Index))
+		{
+			RepairFrom = Point - 1;
+			break;
+		}
+		InEntry.Versions[Point] = Version;
+	}
+
+	// The goal has moved inside its region, the path is extended from the point before the old goal
+	if (RepairFrom == INDEX_NONE && InEntry.Points[LastPoint] != InGoal)
+	{
+		RepairFrom = FMath::Max(LastPoint - 1, InEntry.Cursor);
+	}
+
+	if (RepairFrom == INDEX_NONE)
+	{
+		++NumHits;
+	}
+	else
+	{
+		++NumRepairs;
+	}
+	return RepairFrom;
+}
+
+int32 IT_PathCache::RejoinPath(FEntry& InEntry, const FIntPoint& InStart, const FGrid& InGrid)
+{
+	TArray<FIntPoint, TInlineAllocator<8>> Neighbors;
+	InGrid.ForEachNeighbor(InStart, [&Neighbors](const FGridNeighbor& Neighbor)
+	{
+		Neighbors.Add(Neighbor.Coordinates);
+	});
+
+	// The goal is occupied by the target, the unit can't step onto it
+	int32 RejoinPoint = INDEX_NONE;
+	for (int32 Point = InEntry.Points.Num() - 2; Point >= FMath::Max(InEntry.Cursor, 0); --Point)
+	{
+		if (Neighbors.Contains(InEntry.Points[Point]))
+		{
+			RejoinPoint = Point;
+			break;
+		}
+	}
+	if (RejoinPoint == INDEX_NONE)
+	{
+		return INDEX_NONE;
+	}
+
+	InEntry.Points.RemoveAt(0, RejoinPoint, false);
+	InEntry.Versions.RemoveAt(0, RejoinPoint, false);
+	InEntry.Points.Insert(InStart, 0);
+	InEntry.Versions.Insert(InGrid.GetOccupancyVersion(InGrid.GetIndex(InStart)), 0);
+	InEntry.Cursor = 0;
+	return 0;
+}
+
+void IT_PathCache::SpliceSuffix(FEntry& InEntry, int32 InFromPoint, TConstArrayView<FIntPoint> InPoints,
+                                TConstArrayView<uint32> InVersions)
+{
+	// The suffix starts at the point it was searched from, which is already in the path, unless there is no path yet
+	const int32 FirstNewPoint = InFromPoint != INDEX_NONE ? 1 : 0;
+	InEntry.Points.SetNum(InFromPoint + 1, false);
+	InEntry.Versions.SetNum(InFromPoint + 1, false);
+	InEntry.Points.Append(InPoints.GetData() + FirstNewPoint, InPoints.Num() - FirstNewPoint);
+	InEntry.Versions.Append(InVersions.GetData() + FirstNewPoint, InVersions.Num() - FirstNewPoint);
+}
@@ -0,0 +1,198 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Grid/IT_PathRequestQueue.h"
+
+IT_PathRequestQueue::~IT_PathRequestQueue()
+{
+	WaitForWorkers();
+}
+
+void IT_PathRequestQueue::Init(const FGrid& InGrid, int32 InMaxRequestsPerDispatch, int32 InNumWorkers,
+                               EPathSearchMode InSearchMode)
+{
+	WaitForWorkers();
+
+	MaxRequestsPerDispatch = FMath::Max(InMaxRequestsPerDispatch, 1);
+	SearchMode = InSearchMode;
+
+	Queue.Reset();
+	QueueHead = 0;
+	PendingUnits.Reset();
+	Snapshot = InGrid;
+
+	Workers.Reset();
+	for (int32 WorkerIndex = 0; WorkerIndex < FMath::Max(InNumWorkers, 1); ++WorkerIndex)
+	{
+		TUniquePtr<FWorker>& Worker = Workers.Add_GetRef(MakeUnique<FWorker>());
+		Worker->Pathfinder.InitGraph(Snapshot);
+	}
+}
+
+bool IT_PathRequestQueue::Submit(const FPathRequest& InRequest)
+{
+	if (IsPending(InRequest.UnitId))
+	{
+		return false;
+	}
+
+	if (InRequest.UnitId >= PendingUnits.Num())
+	{
+		PendingUnits.Add(false, InRequest.UnitId + 1 - PendingUnits.Num());
+	}
+	PendingUnits[InRequest.UnitId] = true;
+	Queue.Add(InRequest);
+	return true;
+}
+
+void IT_PathRequestQueue::Cancel(int32 InUnitId)
+{
+	if (PendingUnits.IsValidIndex(InUnitId))
+	{
+		PendingUnits[InUnitId] = false;
+	}
+}
+
+void IT_PathRequestQueue::Dispatch(const FGrid& InGrid)
+{
+	checkf(Workers.Num() > 0, TEXT("[IT_PathRequestQueue::Dispatch] The queue is not initialized."));
+
+	// Take the oldest requests first, skipping the cancelled ones
+	TArray<FPathRequest> Batch;
+	while (QueueHead < Queue.Num() && Batch.Num() < MaxRequestsPerDispatch)
+	{
+		const FPathRequest& Request = Queue[QueueHead++];
+		if (IsPending(Request.UnitId))
+		{
+			Batch.Add(Request);
+		}
+	}
+
+	// Drop the dispatched requests once they pile up, rather than shifting the queue each time
+	if (QueueHead > Queue.Num() / 2)
+	{
+		Queue.RemoveAt(0, QueueHead, false);
+		QueueHead = 0;
+	}
+
+	if (Batch.Num() == 0)
+	{
+		return;
+	}
+
+	Snapshot.CopyOccupancy(InGrid);
+
+	// The requests sharing a goal are answered by a single batched search, so they go to the same worker. Each goal
+	// goes to the least loaded worker so far
+	TMap<FIntPoint, TArray<int32>> RequestsByGoal;
+	for (int32 RequestIndex = 0; RequestIndex < Batch.Num(); ++RequestIndex)
+	{
+		RequestsByGoal.FindOrAdd(Batch[RequestIndex].Goal).Add(RequestIndex);
+	}
+
+	for (const TUniquePtr<FWorker>& Worker : Workers)
+	{
+		checkf(Worker->Task.IsCompleted(), TEXT("[IT_PathRequestQueue::Dispatch] The last dispatch is not collected."));
+		Worker->Requests.Reset();
+	}
+	for (const auto& GoalRequests : RequestsByGoal)
+	{
+		FWorker* LeastLoadedWorker = Workers[0].Get();
+		for (const TUniquePtr<FWorker>& Worker : Workers)
+		{
+			if (Worker->Requests.Num() < LeastLoadedWorker->Requests.Num())
+			{
+				LeastLoadedWorker = Worker.Get();
+			}
+		}
+		for (const int32 RequestIndex : GoalRequests.Value)
+		{
+			LeastLoadedWorker->Requests.Add(Batch[RequestIndex]);
+		}
+	}
+
+	for (const TUniquePtr<FWorker>& WorkerPtr : Workers)
+	{
+		FWorker* Worker = WorkerPtr.Get();
+		if (Worker->Requests.Num() == 0)
+		{
+			continue;
+		}
+
+		Worker->Task = UE::Tasks::Launch(UE_SOURCE_LOCATION, [this, Worker]
+		{
+			TArray<Path::FQuery> Queries;
+			Queries.Reserve(Worker->Requests.Num());
+			for (const FPathRequest& Request : Worker->Requests)
+			{
+				Queries.Add(Path::FQuery{Request.Start, Request.Goal});
+			}
+			const TArray<TArray<Path::FNode>> Paths = Worker->Pathfinder.FindPaths(Queries, SearchMode);
+			Worker->NumExpanded = Worker->Pathfinder.GetNumExpanded();
+
+			Worker->Results.Reset(Worker->Requests.Num());
+			for (int32 RequestIndex = 0; RequestIndex < Worker->Requests.Num(); ++RequestIndex)
+			{
+				FPathResult& Result = Worker->Results.AddDefaulted_GetRef();
+				Result.UnitId = Worker->Requests[RequestIndex].UnitId;
+				Result.Points.Reserve(Paths[RequestIndex].Num());
+				Result.Versions.Reserve(Paths[RequestIndex].Num());
+				for (const Path::FNode& Node : Paths[RequestIndex])
+				{
+					Result.Points.Add(Node.XY);
+					Result.Versions.Add(Snapshot.GetOccupancyVersion(Snapshot.GetIndex(Node.XY)));
+				}
+			}
+		});
+	}
+}
+
+void IT_PathRequestQueue::Collect(TArray<FPathResult>& OutResults)
+{
+	WaitForWorkers();
+
+	int32 NumSearches = 0;
+	int32 NumExpanded = 0;
+	for (const TUniquePtr<FWorker>& Worker : Workers)
+	{
+		NumSearches += Worker->Results.Num();
+		NumExpanded += Worker->NumExpanded;
+		Worker->NumExpanded = 0;
+
+		for (FPathResult& Result : Worker->Results)
+		{
+			// The results of the cancelled requests are dropped
+			if (IsPending(Result.UnitId))
+			{
+				PendingUnits[Result.UnitId] = false;
+				OutResults.Add(MoveTemp(Result));
+			}
+		}
+		Worker->Results.Reset();
+	}
+
+	if (NumSearches > 0)
+	{
+		IT_Pathfinder::TraceExpanded(NumSearches, NumExpanded);
+	}
+}
+
+SIZE_T IT_PathRequestQueue::GetAllocatedSize() const
+{
+	SIZE_T Size = Workers.GetAllocatedSize() + Queue.GetAllocatedSize() + PendingUnits.GetAllocatedSize()
+		+ Snapshot.GetAllocatedSize();
+	for (const TUniquePtr<FWorker>& Worker : Workers)
+	{
+		Size += sizeof(FWorker) + Worker->Pathfinder.GetAllocatedSize() + Worker->Requests.GetAllocatedSize()
+			+ Worker->Results.GetAllocatedSize();
+	}
+	return Size;
+}
+
+void IT_PathRequestQueue::WaitForWorkers()
+{
+	for (const TUniquePtr<FWorker>& Worker : Workers)
+	{
+		Worker->Task.Wait();
+	}
+}
@@ -3,242 +3,653 @@
 
 #include "Grid/IT_Pathfinder.h"
 
-#include <functional>
-
+#include "Grid/IT_PathfinderDiagnostics.h"
 #include "GameModes/IT_GameModeDefault.h" // FGrid
 #include "IlluviumTask/IlluviumTask.h"
 #include "ProfilingDebugging/CountersTrace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
 
 
-TRACE_DECLARE_INT_COUNTER(LessOpCount, TEXT("Less<> Operator() Uses"));
-
-static const int32 ConnectionCost = 1;
+TRACE_DECLARE_INT_COUNTER(PathNodesExpanded, TEXT("Path Nodes Expanded"));
+TRACE_DECLARE_INT_COUNTER(PathNodesPerSearch, TEXT("Path Nodes Per Search"));
 
-bool Path::LessDistancePredicate::operator()(const FNodeRecord2& LeftRecord, const FNodeRecord2& RightRecord) const
+void Path::FOpenList::Init(int32 InNumPoints)
 {
-	TRACE_COUNTER_INCREMENT(LessOpCount);
-	UE_LOG(LogTask, Display, TEXT("LeftRecord: [%s]: Est.Cost: %s, Compare Weight: %s, IsVisited:%s, "
-		       "\nFNodeRecord2 RightRecord[%s]: Est.Cost: %s,Compare Weight: %s, IsVisited:%s"),
-	       *LeftRecord.Node.XY.ToString(), *FString::SanitizeFloat(LeftRecord.EstimatedTotalCost),
-	       *FString::SanitizeFloat(LeftRecord.EstimatedTotalCost * StaticCast<int32>(LeftRecord.VisitStatus)),
-	       *FString(LeftRecord.VisitStatus == Visited ? "Visited" : "NotVisited"),
-	       *RightRecord.Node.XY.ToString(), *FString::SanitizeFloat(RightRecord.EstimatedTotalCost),
-	       *FString::SanitizeFloat(RightRecord.EstimatedTotalCost * StaticCast<int32>(RightRecord.VisitStatus)),
-	       *FString(RightRecord.VisitStatus == Visited ? "Visited" : "NotVisited"));
-	return (LeftRecord.EstimatedTotalCost * StaticCast<int32>(LeftRecord.VisitStatus)
-		< RightRecord.EstimatedTotalCost * StaticCast<int32>(RightRecord.VisitStatus));
-};
+	Heap.Reset();
+	HeapPositions.Init(INDEX_NONE, InNumPoints);
+}
 
-TArray<Path::FConnection> Path::FGraph::GetNodeConnections(const FNodeRecord& InNodeRecord) const
+void Path::FOpenList::Push(int32 InIndex, float InEstimatedTotalCost, float InCostSoFar)
 {
-	// TODO: The function must go through the neighboring Nodes and find the connections of a taken node
-	/*
-	 * We may use the rules of the Grid formation, like: Rect, Hex, Oct. Which will define the directions in which to check if there is a node
-	 * NW NN NE | []		[1;0]		[]
-	 * WW OO EE | [0;-1]	[0;0]		[0;1]
-	 * SW SS SE | []		[-1;0]		[]
-	 * Rect: NN, WW, EE, SS connections.
-	 * Hex: NW, NE, WW, EE, SW, SE connections.
-	 * Oct: All 8 directions.
-	 *
-	 * Using such rules will declare, that all the neighbors are 1 point away from the node with no distance calculations.
-	 * To check: if the coordinates of interest are in bounds of the Grid size and are not below zero
-	 * 0 <= X <= Grid.Size.X
-	 * 0 <= Y <= Grid.Size.Y
-	 */
+	checkf(!Contains(InIndex), TEXT("[FOpenList::Push] Index is already in the open list."));
+	const int32 HeapPosition = Heap.AddUninitialized();
+	Place(FEntry{InIndex, InEstimatedTotalCost, InCostSoFar}, HeapPosition);
+	SiftUp(HeapPosition);
+}
 
-	TArray<Path::FConnection> Connections;
+void Path::FOpenList::DecreaseKey(int32 InIndex, float InEstimatedTotalCost, float InCostSoFar)
+{
+	const int32 HeapPosition = HeapPositions[InIndex];
+	checkf(HeapPosition != INDEX_NONE, TEXT("[FOpenList::DecreaseKey] Index is not in the open list."));
+	Heap[HeapPosition].EstimatedTotalCost = InEstimatedTotalCost;
+	Heap[HeapPosition].CostSoFar = InCostSoFar;
+	SiftUp(HeapPosition);
+}
 
-	auto Points = GridRef.GetNodeConnections(FGridPoint());
+int32 Path::FOpenList::Pop()
+{
+	checkf(!IsEmpty(), TEXT("[FOpenList::Pop] Operation on an empty open list."));
+	const int32 TopIndex = Heap[0].Index;
+	HeapPositions[TopIndex] = INDEX_NONE;
 
-	for (auto Point : Points)
+	const FEntry LastEntry = Heap.Pop(false);
+	if (Heap.Num() > 0)
 	{
-		Path::FConnection Connection;
-		Connection.From = nullptr;
-		Connection.To = nullptr;
-		Connections.Add(Connection);
+		Place(LastEntry, 0);
+		SiftDown(0);
 	}
-
-	return Connections;
+	return TopIndex;
 }
 
-TArray<Path::FNode> Path::FGraph::GetNodeConnections(const FNode& InNode) const
+void Path::FOpenList::Reset()
 {
-	TArray<Path::FNode> NodeConnections;
-
-	auto Points = GridRef.GetNodeConnections(FGridPoint(InNode.XY));
-
-	for (auto Point : Points)
+	for (const FEntry& Entry : Heap)
 	{
-		Path::FNode Node(Point.GridCoords);
-		Node.bIsReachable = (Point.GameActor == nullptr ? true : false);
-		NodeConnections.Emplace(Node);
+		HeapPositions[Entry.Index] = INDEX_NONE;
 	}
+	Heap.Reset();
+}
 
-	return NodeConnections;
+void Path::FOpenList::SiftUp(int32 HeapPosition)
+{
+	const FEntry Entry = Heap[HeapPosition];
+	while (HeapPosition > 0)
+	{
+		const int32 ParentPosition = (HeapPosition - 1) / 2;
+		if (!(Entry < Heap[ParentPosition]))
+		{
+			break;
+		}
+		Place(Heap[ParentPosition], HeapPosition);
+		HeapPosition = ParentPosition;
+	}
+	Place(Entry, HeapPosition);
 }
 
-void IT_Pathfinder::InitGraph(const FGrid& InGrid)
+void Path::FOpenList::SiftDown(int32 HeapPosition)
 {
-	Graph = MakeUnique<Path::FGraph>(InGrid);
+	const FEntry Entry = Heap[HeapPosition];
+	const int32 Num = Heap.Num();
+	while (true)
+	{
+		int32 ChildPosition = HeapPosition * 2 + 1;
+		if (ChildPosition >= Num)
+		{
+			break;
+		}
+		if (ChildPosition + 1 < Num && Heap[ChildPosition + 1] < Heap[ChildPosition])
+		{
+			++ChildPosition;
+		}
+		if (!(Heap[ChildPosition] < Entry))
+		{
+			break;
+		}
+		Place(Heap[ChildPosition], HeapPosition);
+		HeapPosition = ChildPosition;
+	}
+	Place(Entry, HeapPosition);
 }
 
-TArray<Path::FNode> IT_Pathfinder::FindPath(const Path::FNode& InStartNode, const Path::FNode& InEndNode)
+void Path::FOpenList::Place(const FEntry& InEntry, int32 HeapPosition)
 {
-	UE_LOG(LogTask, Display, TEXT("[FindPath] Building a path from %s to %s"), *InStartNode.XY.ToString(),
-	       *InEndNode.XY.ToString());
-	using namespace Path;
+	Heap[HeapPosition] = InEntry;
+	HeapPositions[InEntry.Index] = HeapPosition;
+}
 
-	TArray<FNodeRecord2*> NodesArray;
+void Path::FSearchScratch::Init(int32 InNumPoints)
+{
+	CostSoFar.SetNumUninitialized(InNumPoints);
+	ParentIndices.SetNumUninitialized(InNumPoints);
+	DiscoveredSet.Init(false, InNumPoints);
+	ClosedSet.Init(false, InNumPoints);
+	TouchedIndices.Reset();
+	OpenList.Init(InNumPoints);
+}
 
-	TArray<Path::FNode> ResultNodes;
+void Path::FSearchScratch::Reset()
+{
+	for (const int32 Index : TouchedIndices)
+	{
+		DiscoveredSet[Index] = false;
+		ClosedSet[Index] = false;
+	}
+	TouchedIndices.Reset();
+	OpenList.Reset();
+	NumExpanded = 0;
+}
 
-	//Path::FNodeRecordPtr StartNodeRecord = MakeShared<Path::FNodeRecord>(StartNode);
-	FNodeRecord2* StartNodeRecord = new FNodeRecord2(InStartNode);
-	StartNodeRecord->HeuristicValue = Path::FHeuristic::Estimate(InStartNode, InEndNode);
-	StartNodeRecord->CostSoFar = 0.f;
-	StartNodeRecord->VisitStatus = Discovered;
-	StartNodeRecord->EstimatedTotalCost = StartNodeRecord->HeuristicValue;
+void Path::FSearchScratch::Discover(int32 InIndex, float InCostSoFar, int32 InParentIndex)
+{
+	if (!DiscoveredSet[InIndex])
+	{
+		DiscoveredSet[InIndex] = true;
+		TouchedIndices.Add(InIndex);
+	}
+	CostSoFar[InIndex] = InCostSoFar;
+	ParentIndices[InIndex] = InParentIndex;
+}
 
-	NodesArray.HeapPush(StartNodeRecord, Path::LessDistancePredicate());
+void Path::FSearchScratch::Relax(int32 InIndex, float InCostSoFar, int32 InParentIndex, float InEstimate)
+{
+	if (!IsDiscovered(InIndex))
+	{
+		Discover(InIndex, InCostSoFar, InParentIndex);
+		OpenList.Push(InIndex, InCostSoFar + InEstimate, InCostSoFar);
+	}
+	else if (InCostSoFar < CostSoFar[InIndex])
+	{
+		Discover(InIndex, InCostSoFar, InParentIndex);
+		OpenList.DecreaseKey(InIndex, InCostSoFar + InEstimate, InCostSoFar);
+	}
+}
 
-	Path::FNodeRecord2* CurrentNodeRecord = nullptr;
+/**
+ * Jump point search over the grid occupancy, for the rectangular and octagonal grids.
+ * Instead of every neighbor, only the points where an optimal path may turn (the jump points) are pushed to the open
+ * list. The occupied and the blocked points are the obstacles, except for the end point, like in the plain A*.
+ * Only used on the uniform terrain, where the cost of a segment is its length.
+ * The octagonal rules are the ones of Harabor and Grastien. On the rectangular grids the paths are canonically ordered
+ * horizontal first, so a horizontal jump also scans vertically at every step, and a vertical one stops next to a
+ * passed obstacle.
+ */
+struct FJumpPointGrid
+{
+	FJumpPointGrid(const FGrid& InGrid, int32 InEndIndex)
+		: Grid(InGrid)
+		, EndIndex(InEndIndex)
+		, bDiagonal(InGrid.GetGridType() == EGridType::Octagonal)
+	{
+	}
 
-	while (NodesArray.Num() > 0)
+	bool IsWalkable(int32 X, int32 Y) const
 	{
-		//NodesArray.HeapSort(Path::LessDistancePredicate());
-		for (auto* Node : NodesArray)
+		const FIntPoint Coordinates{X, Y};
+		if (!Grid.IsPointOnGrid(Coordinates))
 		{
-			UE_LOG(LogTask, Display, TEXT("[FindPath] NodeArray Node: %s, Est.Cost: %s. VisitStatus: %s"),
-			       *Node->Node.XY.ToString(),
-			       *FString::SanitizeFloat(Node->EstimatedTotalCost),
-			       *FString(Node->VisitStatus == Visited ? "Visited" : Node->VisitStatus == Discovered ? "Discovered"
-			        : Node->VisitStatus == EVisitStatus::Unvisited ? "Unvisited" : "Broken, or what?"));
+			return false;
 		}
-		if(CurrentNodeRecord == NodesArray.HeapTop())
-		{
-			UE_LOG(LogTask, Display, TEXT("[FindPath] Heap evaluation error. Welcome to the infinite loop! (jk, breaking the loop..)"));
-			break;
-		}
-		//That's how it worked:
-		//CurrentNodeRecord = NodesArray.HeapTop();
-
-		// Update the current node's heap position with the new VisitStatus 
-		NodesArray.HeapPop(CurrentNodeRecord, Path::LessDistancePredicate(), false);
-		CurrentNodeRecord->VisitStatus = Visited;
-		NodesArray.HeapPush(CurrentNodeRecord, Path::LessDistancePredicate());
-		//~
-		
-		// Check if the current node is the target node
-		if (CurrentNodeRecord->Node == InEndNode)
-		{
-			break;
-		}
-
-		UE_LOG(LogTask, Display, TEXT("[FindPath]Current Node: %s"), *CurrentNodeRecord->Node.XY.ToString());
+		const int32 Index = Grid.GetIndex(Coordinates);
+		return !Grid.IsBlocked(Index) && (Index == EndIndex || !Grid.IsOccupied(Index));
+	}
 
-		// // Get the current node's connections and iterate through them
-		TArray<Path::FNode> NeighborNodes = Graph->GetNodeConnections(CurrentNodeRecord->Node);
-		for (auto& NeighborNode : NeighborNodes)
+	/**
+	 * Moves from the point in the direction until it reaches a jump point
+	 * @return Index of the jump point, INDEX_NONE if the move runs into an obstacle or off the grid first
+	 */
+	int32 Jump(FIntPoint Coordinates, const FIntPoint& Direction) const
+	{
+		const int32 DX = Direction.X;
+		const int32 DY = Direction.Y;
+		while (true)
 		{
-			UE_LOG(LogTask, Display, TEXT("[FindPath]   Neighbor Node: %s is %s"), *NeighborNode.XY.ToString(),
-			       *FString(NeighborNode.bIsReachable ? "reachable" : "not reachable"));
-			if (!NeighborNode.bIsReachable)
+			Coordinates += Direction;
+			const int32 X = Coordinates.X;
+			const int32 Y = Coordinates.Y;
+			if (!IsWalkable(X, Y))
 			{
-				continue;
+				return INDEX_NONE;
 			}
-			Path::FNodeRecord2 NextNodeRecord(NeighborNode);
-			const float NextNodeCost = CurrentNodeRecord->CostSoFar + ConnectionCost;
-			float NextNodeHeuristicValeue = 0.f;
 
-			auto SearchPredicate = [&NextNodeRecord](const FNodeRecord2* NodeRecord)
+			const int32 Index = Grid.GetIndex(Coordinates);
+			if (Index == EndIndex)
 			{
-				return NextNodeRecord.Node == NodeRecord->Node;
-			};
+				return Index;
+			}
 
-			//Connections may lead to discovered nodes
-			if (auto* FoundNode = NodesArray.FindByPredicate(SearchPredicate))
+			if (bDiagonal)
 			{
-				if ((*FoundNode)->CostSoFar >= NextNodeCost)
+				if (DX != 0 && DY != 0)
+				{
+					if ((IsWalkable(X - DX, Y + DY) && !IsWalkable(X - DX, Y))
+						|| (IsWalkable(X + DX, Y - DY) && !IsWalkable(X, Y - DY)))
+					{
+						return Index;
+					}
+					// A diagonal jump stops where one of its straight components finds a jump point
+					if (Jump(Coordinates, {DX, 0}) != INDEX_NONE || Jump(Coordinates, {0, DY}) != INDEX_NONE)
+					{
+						return Index;
+					}
+				}
+				else if (DX != 0)
 				{
-					continue;
+					if ((IsWalkable(X + DX, Y + 1) && !IsWalkable(X, Y + 1))
+						|| (IsWalkable(X + DX, Y - 1) && !IsWalkable(X, Y - 1)))
+					{
+						return Index;
+					}
 				}
+				else
+				{
+					if ((IsWalkable(X + 1, Y + DY) && !IsWalkable(X + 1, Y))
+						|| (IsWalkable(X - 1, Y + DY) && !IsWalkable(X - 1, Y)))
+					{
+						return Index;
+					}
+				}
+			}
+			else if (DX != 0)
+			{
+				if (Jump(Coordinates, {0, 1}) != INDEX_NONE || Jump(Coordinates, {0, -1}) != INDEX_NONE)
+				{
+					return Index;
+				}
+			}
+			else
+			{
+				if ((IsWalkable(X + 1, Y) && !IsWalkable(X + 1, Y - DY))
+					|| (IsWalkable(X - 1, Y) && !IsWalkable(X - 1, Y - DY)))
+				{
+					return Index;
+				}
+			}
+		}
+	}
 
-				NextNodeHeuristicValeue = (*FoundNode)->EstimatedTotalCost - (*FoundNode)->CostSoFar;
-				NextNodeRecord.VisitStatus = (*FoundNode)->VisitStatus;
+	/**
+	 * Calls the visitor for every direction to jump in from the point: the natural and the forced ones
+	 * @param Coordinates The jump point
+	 * @param ParentIndex Index of the jump point it was reached from, INDEX_NONE for the start point
+	 * @param Visitor Called as Visitor(const FIntPoint& Direction)
+	 */
+	template <typename FVisitor>
+	void ForEachDirection(const FIntPoint& Coordinates, int32 ParentIndex, FVisitor&& Visitor) const
+	{
+		if (ParentIndex == INDEX_NONE)
+		{
+			Grid.ForEachNeighbor(Coordinates, [&Coordinates, &Visitor](const FGridNeighbor& Neighbor)
+			{
+				Visitor(Neighbor.Coordinates - Coordinates);
+			});
+			return;
+		}
+
+		const FIntPoint ParentCoordinates = Grid.GetCoordinates(ParentIndex);
+		const int32 DX = FMath::Sign(Coordinates.X - ParentCoordinates.X);
+		const int32 DY = FMath::Sign(Coordinates.Y - ParentCoordinates.Y);
+		const int32 X = Coordinates.X;
+		const int32 Y = Coordinates.Y;
 
-				// If a visited node somehow becomes effective again, make it visitable
-				if ((*FoundNode)->VisitStatus == Visited)
+		if (bDiagonal)
+		{
+			if (DX != 0 && DY != 0)
+			{
+				Visitor(FIntPoint{DX, 0});
+				Visitor(FIntPoint{0, DY});
+				Visitor(FIntPoint{DX, DY});
+				if (!IsWalkable(X - DX, Y))
+				{
+					Visitor(FIntPoint{-DX, DY});
+				}
+				if (!IsWalkable(X, Y - DY))
+				{
+					Visitor(FIntPoint{DX, -DY});
+				}
+			}
+			else if (DX != 0)
+			{
+				Visitor(FIntPoint{DX, 0});
+				if (!IsWalkable(X, Y + 1))
 				{
-					(*FoundNode)->VisitStatus = Discovered;
+					Visitor(FIntPoint{DX, 1});
+				}
+				if (!IsWalkable(X, Y - 1))
+				{
+					Visitor(FIntPoint{DX, -1});
 				}
 			}
-			// Or to a new undiscovered node
 			else
 			{
-				NextNodeHeuristicValeue = Path::FHeuristic::Estimate(NeighborNode, InEndNode);
+				Visitor(FIntPoint{0, DY});
+				if (!IsWalkable(X + 1, Y))
+				{
+					Visitor(FIntPoint{1, DY});
+				}
+				if (!IsWalkable(X - 1, Y))
+				{
+					Visitor(FIntPoint{-1, DY});
+				}
+			}
+		}
+		else if (DX != 0)
+		{
+			Visitor(FIntPoint{DX, 0});
+			Visitor(FIntPoint{0, 1});
+			Visitor(FIntPoint{0, -1});
+		}
+		else
+		{
+			Visitor(FIntPoint{0, DY});
+			if (!IsWalkable(X + 1, Y - DY))
+			{
+				Visitor(FIntPoint{1, 0});
+			}
+			if (!IsWalkable(X - 1, Y - DY))
+			{
+				Visitor(FIntPoint{-1, 0});
 			}
+		}
+	}
+
+	const FGrid& Grid;
+	const int32 EndIndex;
+	const bool bDiagonal;
+};
 
-			NextNodeRecord.HeuristicValue = NextNodeHeuristicValeue;
-			NextNodeRecord.CostSoFar = NextNodeCost;
-			NextNodeRecord.ParentNodePtr = CurrentNodeRecord;
-			NextNodeRecord.EstimatedTotalCost = NextNodeCost + NextNodeHeuristicValeue;
+void IT_Pathfinder::InitGraph(const FGrid& InGrid)
+{
+	Graph = MakeUnique<Path::FGraph>(InGrid);
+}
+
+TArray<Path::FNode> IT_Pathfinder::FindPath(const Path::FNode& InStartNode, const Path::FNode& InEndNode,
+                                            EPathSearchMode InSearchMode)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IT_FindPath);
+	NumExpanded = 0;
+	IT_PATH_TRACE(TEXT("[FindPath] Building a path from %s to %s"), *InStartNode.XY.ToString(),
+	              *InEndNode.XY.ToString());
+	using namespace Path;
+
+	TArray<Path::FNode> ResultNodes;
+
+	if (!Graph.IsValid())
+	{
+		UE_LOG(LogTask, Warning, TEXT("[FindPath] The graph is not initialized."));
+		return ResultNodes;
+	}
+
+	const FGrid& Grid = Graph->GridRef;
+	if (!Grid.IsPointOnGrid(InStartNode.XY) || !Grid.IsPointOnGrid(InEndNode.XY))
+	{
+		UE_LOG(LogTask, Warning, TEXT("[FindPath] Start or end node is out of the grid."));
+		return ResultNodes;
+	}
 
-			if (NextNodeRecord.VisitStatus == Unvisited)
+	if (Scratch.Num() != Grid.Num())
+	{
+		Scratch.Init(Grid.Num());
+	}
+	Scratch.Reset();
+
+	const int32 StartIndex = Grid.GetIndex(InStartNode.XY);
+	const int32 EndIndex = Grid.GetIndex(InEndNode.XY);
+
+	const Path::FHeuristic Heuristic(Grid, InEndNode);
+	Scratch.Relax(StartIndex, 0.f, INDEX_NONE, Heuristic.Estimate(InStartNode));
+
+	// There are no jump point rules for the hexagonal grids, and the jumps assume the uniform costs
+	const bool bJumpPointSearch = InSearchMode == EPathSearchMode::JumpPoint
+		&& Grid.GetGridType() != EGridType::Hexagonal && Grid.HasUniformTerrain();
+	const bool bPathFound = bJumpPointSearch
+		                        ? SearchJumpPoints(Grid, EndIndex, Heuristic)
+		                        : SearchAStar(Grid, EndIndex, Heuristic);
+	NumExpanded = Scratch.NumExpanded;
+
+	if (!bPathFound)
+	{
+		IT_PATH_TRACE(TEXT("[FindPath] No path could be found from %s to %s"), *InStartNode.XY.ToString(),
+		              *InEndNode.XY.ToString());
+		return ResultNodes;
+	}
+
+	for (int32 Index = EndIndex; Index != INDEX_NONE; Index = Scratch.ParentIndices[Index])
+	{
+		const FIntPoint Coordinates = Grid.GetCoordinates(Index);
+		ResultNodes.Add(FNode{Coordinates, true});
+
+		// The jump points are linked by straight or diagonal segments, fill in the points between them
+		const int32 ParentIndex = Scratch.ParentIndices[Index];
+		if (ParentIndex != INDEX_NONE)
+		{
+			const FIntPoint ParentCoordinates = Grid.GetCoordinates(ParentIndex);
+			const FIntPoint Step{
+				FMath::Sign(ParentCoordinates.X - Coordinates.X), FMath::Sign(ParentCoordinates.Y - Coordinates.Y)
+			};
+			for (FIntPoint Point = Coordinates + Step; Point != ParentCoordinates; Point += Step)
 			{
-				NextNodeRecord.VisitStatus = Discovered;
-				NodesArray.HeapPush(new FNodeRecord2(NextNodeRecord), Path::LessDistancePredicate());
+				ResultNodes.Add(FNode{Point, true});
 			}
 		}
-		//CurrentNodeRecord->VisitStatus = Visited;
-		// TODO: check what's better - to sort the Heap, or to Pop and Push back a single element.
-		//NodesArray.HeapSort(Path::LessDistancePredicate());
 	}
+	Algo::Reverse(ResultNodes);
+
+	if (IT_PATH_TRACE_ENABLED())
+	{
+		FString NodesString;
+		for (const auto& Node : ResultNodes)
+		{
+			NodesString.Appendf(TEXT(" [%s] "), *Node.XY.ToString());
+		}
+		IT_PATH_TRACE(TEXT("[FindPath] Path found: %s"), *NodesString);
+	}
+	return ResultNodes;
+}
 
-	if (CurrentNodeRecord->Node != InEndNode)
+TArray<TArray<Path::FNode>> IT_Pathfinder::FindPaths(TConstArrayView<Path::FQuery> InQueries,
+                                                     EPathSearchMode InSearchMode)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(IT_FindPaths);
+	using namespace Path;
+
+	NumExpanded = 0;
+	int32 NumExpandedTotal = 0;
+
+	TArray<TArray<FNode>> Paths;
+	Paths.SetNum(InQueries.Num());
+
+	if (!Graph.IsValid())
 	{
-		UE_LOG(LogTask, Display, TEXT("[FindPath] No path could be found from %s to %s"), *InStartNode.XY.ToString(),
-		   *InEndNode.XY.ToString());
-		return TArray<Path::FNode>();
+		UE_LOG(LogTask, Warning, TEXT("[FindPaths] The graph is not initialized."));
+		return Paths;
 	}
-	else
+
+	const FGrid& Grid = Graph->GridRef;
+	TMap<FIntPoint, TArray<int32>> QueriesByGoal;
+	for (int32 Query = 0; Query < InQueries.Num(); ++Query)
 	{
-		while (CurrentNodeRecord != nullptr)
+		if (!Grid.IsPointOnGrid(InQueries[Query].Start) || !Grid.IsPointOnGrid(InQueries[Query].Goal))
 		{
-			ResultNodes.Add(CurrentNodeRecord->Node);
-			if (auto* ParentNode = CurrentNodeRecord->ParentNodePtr)
+			UE_LOG(LogTask, Warning, TEXT("[FindPaths] Start or goal of query %d is out of the grid."), Query);
+			continue;
+		}
+		QueriesByGoal.FindOrAdd(InQueries[Query].Goal).Add(Query);
+	}
+
+	if (Scratch.Num() != Grid.Num())
+	{
+		Scratch.Init(Grid.Num());
+	}
+	if (BatchStarts.Num() != Grid.Num())
+	{
+		BatchStarts.Init(false, Grid.Num());
+	}
+
+	for (const auto& Group : QueriesByGoal)
+	{
+		const TArray<int32>& GroupQueries = Group.Value;
+		if (GroupQueries.Num() == 1)
+		{
+			const FQuery& Query = InQueries[GroupQueries[0]];
+			Paths[GroupQueries[0]] = FindPath(FNode{Query.Start, true}, FNode{Query.Goal, true}, InSearchMode);
+			NumExpandedTotal += NumExpanded;
+			continue;
+		}
+
+		int32 NumStarts = 0;
+		for (const int32 Query : GroupQueries)
+		{
+			const int32 StartIndex = Grid.GetIndex(InQueries[Query].Start);
+			if (!BatchStarts[StartIndex])
 			{
-				CurrentNodeRecord = ParentNode;
+				BatchStarts[StartIndex] = true;
+				++NumStarts;
 			}
-			else
+		}
+
+		SearchReverse(Grid, Grid.GetIndex(Group.Key), NumStarts);
+		NumExpandedTotal += Scratch.NumExpanded;
+
+		for (const int32 Query : GroupQueries)
+		{
+			const int32 StartIndex = Grid.GetIndex(InQueries[Query].Start);
+			BatchStarts[StartIndex] = false;
+			if (!Scratch.ClosedSet[StartIndex])
+			{
+				continue;
+			}
+
+			// The parents of the reverse search lead towards the goal
+			TArray<FNode>& QueryPath = Paths[Query];
+			for (int32 Index = StartIndex; Index != INDEX_NONE; Index = Scratch.ParentIndices[Index])
 			{
-				break;
+				QueryPath.Add(FNode{Grid.GetCoordinates(Index), true});
 			}
 		}
-		Algo::Reverse(ResultNodes);
 	}
+	NumExpanded = NumExpandedTotal;
+	return Paths;
+}
 
-	// TODO: make sure, that 
-	NodesArray = TArray<FNodeRecord2*>();
-	/*for (auto* entry : NodesArray)
+void IT_Pathfinder::TraceExpanded(int32 InNumSearches, int32 InNumExpanded)
+{
+	check(IsInGameThread());
+	TRACE_COUNTER_ADD(PathNodesExpanded, InNumExpanded);
+	TRACE_COUNTER_SET(PathNodesPerSearch, InNumSearches > 0 ? InNumExpanded / InNumSearches : 0);
+}
+
+void IT_Pathfinder::SearchReverse(const FGrid& InGrid, int32 InGoalIndex, int32 InNumStarts)
+{
+	Scratch.Reset();
+	Scratch.Relax(InGoalIndex, 0.f, INDEX_NONE, 0.f);
+
+	int32 NumSettledStarts = 0;
+	while (!Scratch.OpenList.IsEmpty())
 	{
-		delete entry;
-	}*/
+		const int32 CurrentIndex = Scratch.OpenList.Pop();
+		Scratch.ClosedSet[CurrentIndex] = true;
+		++Scratch.NumExpanded;
 
+		if (BatchStarts[CurrentIndex] && ++NumSettledStarts == InNumStarts)
+		{
+			return;
+		}
 
-	FString NodesString;
-	for (auto Node : ResultNodes)
+		// The starts are usually units, the paths of the others don't pass through them
+		if (BatchStarts[CurrentIndex] && CurrentIndex != InGoalIndex)
+		{
+			continue;
+		}
+
+		// The connection costs are symmetric, so the reverse search finds the same costs as the forward ones
+		InGrid.ForEachNeighbor(InGrid.GetCoordinates(CurrentIndex), [&](const FGridNeighbor& Neighbor)
+		{
+			if (Scratch.ClosedSet[Neighbor.Index]
+				|| (InGrid.IsOccupied(Neighbor.Index) && !BatchStarts[Neighbor.Index]))
+			{
+				return;
+			}
+			Scratch.Relax(Neighbor.Index, Scratch.CostSoFar[CurrentIndex] + Neighbor.Cost, CurrentIndex, 0.f);
+		});
+	}
+}
+
+bool IT_Pathfinder::SearchAStar(const FGrid& InGrid, int32 InEndIndex, const Path::FHeuristic& InHeuristic)
+{
+	using namespace Path;
+
+	while (!Scratch.OpenList.IsEmpty())
 	{
-		NodesString.Appendf(TEXT(" [%s] "), *Node.XY.ToString());
+		const int32 CurrentIndex = Scratch.OpenList.Pop();
+		Scratch.ClosedSet[CurrentIndex] = true;
+		++Scratch.NumExpanded;
+
+		// Check if the current node is the target node
+		if (CurrentIndex == InEndIndex)
+		{
+			return true;
+		}
+
+		const FNode CurrentNode(InGrid.GetCoordinates(CurrentIndex));
+		IT_PATH_TRACE(TEXT("[FindPath] Current Node: %s"), *CurrentNode.XY.ToString());
+
+		// Iterate through the current node's connections
+		Graph->ForEachNodeConnection(CurrentNode, [&](const FNode& NeighborNode, int32 NeighborIndex,
+		                                              float ConnectionCost)
+		{
+			IT_PATH_TRACE(TEXT("[FindPath]   Neighbor Node: %s is %s"), *NeighborNode.XY.ToString(),
+			              NeighborNode.bIsReachable ? TEXT("reachable") : TEXT("not reachable"));
+
+			// The end node is usually occupied by the target itself, but it still terminates the path
+			if ((!NeighborNode.bIsReachable && NeighborIndex != InEndIndex) || Scratch.ClosedSet[NeighborIndex])
+			{
+				return;
+			}
+
+			const float NextNodeCost = Scratch.CostSoFar[CurrentIndex] + ConnectionCost;
+			Scratch.Relax(NeighborIndex, NextNodeCost, CurrentIndex, InHeuristic.Estimate(NeighborNode));
+		});
 	}
+	return false;
+}
 
-	UE_LOG(LogTask, Display, TEXT("[FindPath] Path found: %s"), *NodesString);
-	return ResultNodes;
+bool IT_Pathfinder::SearchJumpPoints(const FGrid& InGrid, int32 InEndIndex, const Path::FHeuristic& InHeuristic)
+{
+	using namespace Path;
+
+	const FJumpPointGrid JumpPointGrid(InGrid, InEndIndex);
+
+	while (!Scratch.OpenList.IsEmpty())
+	{
+		const int32 CurrentIndex = Scratch.OpenList.Pop();
+		Scratch.ClosedSet[CurrentIndex] = true;
+		++Scratch.NumExpanded;
+
+		if (CurrentIndex == InEndIndex)
+		{
+			return true;
+		}
+
+		const FIntPoint CurrentCoordinates = InGrid.GetCoordinates(CurrentIndex);
+		IT_PATH_TRACE(TEXT("[FindPath] Current Jump Point: %s"), *CurrentCoordinates.ToString());
+
+		const int32 ParentIndex = Scratch.ParentIndices[CurrentIndex];
+		JumpPointGrid.ForEachDirection(CurrentCoordinates, ParentIndex, [&](const FIntPoint& Direction)
+		{
+			const int32 JumpIndex = JumpPointGrid.Jump(CurrentCoordinates, Direction);
+			if (JumpIndex == INDEX_NONE || Scratch.ClosedSet[JumpIndex])
+			{
+				return;
+			}
+
+			// The segment between the jump points is straight or diagonal, so its cost is the obstacle-free distance
+			const FNode JumpNode{InGrid.GetCoordinates(JumpIndex), true};
+			const float NextNodeCost = Scratch.CostSoFar[CurrentIndex]
+				+ InGrid.GetDistance(CurrentCoordinates, JumpNode.XY);
+			Scratch.Relax(JumpIndex, NextNodeCost, CurrentIndex, InHeuristic.Estimate(JumpNode));
+		});
+	}
+	return false;
 }
 
 TArray<Path::FNode> IT_Pathfinder::GetNeighbors(const Path::FNode& InNode)
 {
-	return Graph->GetNodeConnections(InNode);
+	TArray<Path::FNode> Neighbors;
+	Graph->ForEachNodeConnection(InNode, [&Neighbors](const Path::FNode& NeighborNode, int32, float)
+	{
+		Neighbors.Add(NeighborNode);
+	});
+	return Neighbors;
 }
 
 void IT_Pathfinder::VisualizePath(UWorld* World, TArray<Path::FNode> Array, float GridScale)
@@ -274,8 +685,8 @@ void IT_Pathfinder::VisualizePath(UWorld* World, TArray<Path::FNode> Array, floa
 			100.f
 		};
 		DrawDebugLine(World, PreviousLocation, NodeVec, FColor::Green, true, 100.f, 10, 5.f);
-		UE_LOG(LogTask, Display, TEXT("[VisualizePath] Draw line from %s to %s."), *PreviousLocation.ToString(),
-		       *NodeVec.ToString());
+		IT_PATH_TRACE(TEXT("[VisualizePath] Draw line from %s to %s."), *PreviousLocation.ToString(),
+		              *NodeVec.ToString());
 		PreviousLocation = NodeVec;
 	}
 }
@@ -0,0 +1,19 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Grid/IT_PathfinderDiagnostics.h"
+
+#include "HAL/IConsoleManager.h"
+
+#if IT_PATHFINDING_TRACE
+
+int32 Path::Diagnostics::GTraceEnabled = 0;
+
+static FAutoConsoleVariableRef CVarPathfindingTrace(
+	TEXT("it.Pathfinding.Trace"),
+	Path::Diagnostics::GTraceEnabled,
+	TEXT("Logs every pathfinding query, node expansion and visualized segment to LogTaskPathfinding.\n")
+	TEXT("0: off (default), 1: on"),
+	ECVF_Cheat);
+
+#endif
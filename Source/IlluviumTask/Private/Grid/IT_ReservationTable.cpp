@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Grid/IT_ReservationTable.h"
+
+void IT_ReservationTable::Init(int32 InNumPoints, int32 InWindow)
+{
+	NumPoints = InNumPoints;
+	Window = FMath::Max(InWindow, 1);
+	Reservations.Reset();
+}
+
+void IT_ReservationTable::Reset()
+{
+	// Keeps the allocation for the next turn
+	Reservations.Reset();
+}
+
+void IT_ReservationTable::Reserve(int32 InIndex, int32 InTime, int32 InUnitId)
+{
+	Reservations.Add(GetEntry(InIndex, InTime), InUnitId);
+}
+
+void IT_ReservationTable::ReserveFrom(int32 InIndex, int32 InFromTime, int32 InUnitId)
+{
+	for (int32 Time = InFromTime; Time <= Window; ++Time)
+	{
+		Reserve(InIndex, Time, InUnitId);
+	}
+}
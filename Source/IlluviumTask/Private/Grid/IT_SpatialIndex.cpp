@@ -0,0 +1,166 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Grid/IT_SpatialIndex.h"
+
+void IT_SpatialIndex::Init(int32 InGridSizeX, int32 InGridSizeY, int32 InBucketSize)
+{
+	BucketSize = FMath::Max(1, InBucketSize);
+	NumBucketsX = FMath::DivideAndRoundUp(FMath::Max(1, InGridSizeX), BucketSize);
+	NumBucketsY = FMath::DivideAndRoundUp(FMath::Max(1, InGridSizeY), BucketSize);
+	TeamBuckets.Reset();
+}
+
+void IT_SpatialIndex::Add(int32 InUnitId, ETeam InTeam, const FIntPoint& InCoordinates)
+{
+	TArray<FBucket>& Buckets = TeamBuckets.FindOrAdd(InTeam);
+	if (Buckets.Num() == 0)
+	{
+		Buckets.SetNum(NumBucketsX * NumBucketsY);
+	}
+	Buckets[GetBucketIndex(InCoordinates)].Add(FEntry{InUnitId, InCoordinates});
+}
+
+void IT_SpatialIndex::Remove(int32 InUnitId, ETeam InTeam, const FIntPoint& InCoordinates)
+{
+	if (TArray<FBucket>* Buckets = TeamBuckets.Find(InTeam))
+	{
+		FBucket& Bucket = (*Buckets)[GetBucketIndex(InCoordinates)];
+		const int32 EntryIndex = Bucket.IndexOfByPredicate([InUnitId](const FEntry& Entry)
+		{
+			return Entry.UnitId == InUnitId;
+		});
+		if (EntryIndex != INDEX_NONE)
+		{
+			Bucket.RemoveAtSwap(EntryIndex, 1, false);
+		}
+	}
+}
+
+void IT_SpatialIndex::Move(int32 InUnitId, ETeam InTeam, const FIntPoint& InFromCoordinates,
+                           const FIntPoint& InToCoordinates)
+{
+	TArray<FBucket>* Buckets = TeamBuckets.Find(InTeam);
+	if (Buckets == nullptr)
+	{
+		return;
+	}
+
+	const int32 FromBucketIndex = GetBucketIndex(InFromCoordinates);
+	const int32 ToBucketIndex = GetBucketIndex(InToCoordinates);
+	FBucket& FromBucket = (*Buckets)[FromBucketIndex];
+	const int32 EntryIndex = FromBucket.IndexOfByPredicate([InUnitId](const FEntry& Entry)
+	{
+		return Entry.UnitId == InUnitId;
+	});
+	if (EntryIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	if (FromBucketIndex == ToBucketIndex)
+	{
+		FromBucket[EntryIndex].Coordinates = InToCoordinates;
+	}
+	else
+	{
+		FromBucket.RemoveAtSwap(EntryIndex, 1, false);
+		(*Buckets)[ToBucketIndex].Add(FEntry{InUnitId, InToCoordinates});
+	}
+}
+
+int32 IT_SpatialIndex::FindClosestOpponent(const FIntPoint& InCoordinates, ETeam InTeam, int32& OutDistanceSqr) const
+{
+	int32 ClosestUnitId = INDEX_NONE;
+	int32 ClosestDistSqr = MAX_int32;
+
+	const int32 CenterX = FMath::Clamp(InCoordinates.X / BucketSize, 0, NumBucketsX - 1);
+	const int32 CenterY = FMath::Clamp(InCoordinates.Y / BucketSize, 0, NumBucketsY - 1);
+	const int32 MaxRing = FMath::Max(NumBucketsX, NumBucketsY);
+
+	auto SearchBucket = [&](int32 BucketX, int32 BucketY)
+	{
+		const int32 BucketIndex = BucketX + BucketY * NumBucketsX;
+		for (const auto& Team : TeamBuckets)
+		{
+			if (Team.Key == InTeam)
+			{
+				continue;
+			}
+			for (const FEntry& Entry : Team.Value[BucketIndex])
+			{
+				const int32 DistSqr = FIntPoint(Entry.Coordinates - InCoordinates).SizeSquared();
+				if (DistSqr < ClosestDistSqr)
+				{
+					ClosestDistSqr = DistSqr;
+					ClosestUnitId = Entry.UnitId;
+				}
+			}
+		}
+	};
+
+	for (int32 Ring = 0; Ring <= MaxRing; ++Ring)
+	{
+		const int32 MinX = CenterX - Ring;
+		const int32 MaxX = CenterX + Ring;
+		const int32 MinY = CenterY - Ring;
+		const int32 MaxY = CenterY + Ring;
+
+		// Walk the bucket ring: full top and bottom rows, then the left and right columns between them
+		for (int32 BucketX = FMath::Max(MinX, 0); BucketX <= FMath::Min(MaxX, NumBucketsX - 1); ++BucketX)
+		{
+			if (MinY >= 0)
+			{
+				SearchBucket(BucketX, MinY);
+			}
+			if (Ring > 0 && MaxY < NumBucketsY)
+			{
+				SearchBucket(BucketX, MaxY);
+			}
+		}
+		for (int32 BucketY = FMath::Max(MinY + 1, 0); BucketY <= FMath::Min(MaxY - 1, NumBucketsY - 1); ++BucketY)
+		{
+			if (MinX >= 0)
+			{
+				SearchBucket(MinX, BucketY);
+			}
+			if (MaxX < NumBucketsX)
+			{
+				SearchBucket(MaxX, BucketY);
+			}
+		}
+
+		// Anything beyond this ring is at least Ring * BucketSize + 1 cells away on one of the axes
+		if (ClosestUnitId != INDEX_NONE && ClosestDistSqr <= FMath::Square(Ring * BucketSize + 1))
+		{
+			break;
+		}
+	}
+
+	if (ClosestUnitId != INDEX_NONE)
+	{
+		OutDistanceSqr = ClosestDistSqr;
+	}
+	return ClosestUnitId;
+}
+
+int32 IT_SpatialIndex::GetBucketIndex(const FIntPoint& InCoordinates) const
+{
+	const int32 BucketX = FMath::Clamp(InCoordinates.X / BucketSize, 0, NumBucketsX - 1);
+	const int32 BucketY = FMath::Clamp(InCoordinates.Y / BucketSize, 0, NumBucketsY - 1);
+	return BucketX + BucketY * NumBucketsX;
+}
+
+SIZE_T IT_SpatialIndex::GetAllocatedSize() const
+{
+	SIZE_T Size = TeamBuckets.GetAllocatedSize();
+	for (const auto& Buckets : TeamBuckets)
+	{
+		Size += Buckets.Value.GetAllocatedSize();
+		for (const FBucket& Bucket : Buckets.Value)
+		{
+			Size += Bucket.GetAllocatedSize();
+		}
+	}
+	return Size;
+}
@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Grid/IT_TerrainMap.h"
+
+#include "IImageWrapper.h"
+#include "IImageWrapperModule.h"
+#include "IlluviumTask/IlluviumTask.h"
+#include "Misc/FileHelper.h"
+#include "Modules/ModuleManager.h"
+
+bool UIT_TerrainMap::LoadImage(const FString& InPath, int32& OutSizeX, int32& OutSizeY, TArray<uint8>& OutCosts)
+{
+	TArray<uint8> CompressedData;
+	if (!FFileHelper::LoadFileToArray(CompressedData, *InPath))
+	{
+		UE_LOG(LogTask, Warning, TEXT("[UIT_TerrainMap::LoadImage] Failed to read %s."), *InPath);
+		return false;
+	}
+
+	IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(
+		TEXT("ImageWrapper"));
+	const EImageFormat ImageFormat = ImageWrapperModule.DetectImageFormat(CompressedData.GetData(),
+	                                                                      CompressedData.Num());
+	const TSharedPtr<IImageWrapper> ImageWrapper = ImageWrapperModule.CreateImageWrapper(ImageFormat);
+
+	TArray64<uint8> RawData;
+	if (!ImageWrapper.IsValid() || !ImageWrapper->SetCompressed(CompressedData.GetData(), CompressedData.Num())
+		|| !ImageWrapper->GetRaw(ERGBFormat::Gray, 8, RawData))
+	{
+		UE_LOG(LogTask, Warning, TEXT("[UIT_TerrainMap::LoadImage] Failed to decode %s."), *InPath);
+		return false;
+	}
+
+	OutSizeX = StaticCast<int32>(ImageWrapper->GetWidth());
+	OutSizeY = StaticCast<int32>(ImageWrapper->GetHeight());
+	OutCosts.SetNumUninitialized(OutSizeX * OutSizeY);
+	FMemory::Memcpy(OutCosts.GetData(), RawData.GetData(), OutCosts.Num());
+	return true;
+}
+
+#if WITH_EDITOR
+void UIT_TerrainMap::ImportSourceImage()
+{
+	int32 ImageSizeX = 0;
+	int32 ImageSizeY = 0;
+	TArray<uint8> ImageCosts;
+	if (!LoadImage(SourceImage.FilePath, ImageSizeX, ImageSizeY, ImageCosts))
+	{
+		return;
+	}
+
+	Modify();
+	SizeX = ImageSizeX;
+	SizeY = ImageSizeY;
+	Costs = MoveTemp(ImageCosts);
+}
+#endif
@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Simulation/IT_FixedStepScheduler.h"
+
+void FFixedStepScheduler::Init(float InStepSeconds, int32 InMaxStepsPerFrame)
+{
+	StepSeconds = FMath::Max(InStepSeconds, UE_KINDA_SMALL_NUMBER);
+	MaxStepsPerFrame = FMath::Max(InMaxStepsPerFrame, 1);
+	Reset();
+}
+
+void FFixedStepScheduler::Reset()
+{
+	Accumulator = 0.0;
+}
+
+int32 FFixedStepScheduler::Advance(float InDeltaSeconds)
+{
+	Accumulator += FMath::Max(InDeltaSeconds, 0.f);
+
+	int32 NumSteps = FMath::FloorToInt32(Accumulator / StepSeconds);
+	if (NumSteps > MaxStepsPerFrame)
+	{
+		// Keep the fraction of a step, so the interpolation stays continuous, but give up on the whole steps
+		NumSteps = MaxStepsPerFrame;
+		Accumulator = FMath::Fmod(Accumulator, StaticCast<double>(StepSeconds));
+	}
+	else
+	{
+		Accumulator -= NumSteps * StaticCast<double>(StepSeconds);
+	}
+	return NumSteps;
+}
+
+float FFixedStepScheduler::GetAlpha() const
+{
+	return FMath::Clamp(StaticCast<float>(Accumulator / StepSeconds), 0.f, 1.f);
+}
@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Simulation/IT_SimulationRandom.h"
+
+// The SplitMix64 finalizer, spreads the close seeds far apart
+static uint64 MixSeed(uint64 InValue)
+{
+	InValue += 0x9E3779B97F4A7C15ull;
+	InValue = (InValue ^ (InValue >> 30)) * 0xBF58476D1CE4E5B9ull;
+	InValue = (InValue ^ (InValue >> 27)) * 0x94D049BB133111EBull;
+	return InValue ^ (InValue >> 31);
+}
+
+void FSimulationRandomStream::Init(uint64 InSeed, uint64 InSequence)
+{
+	// The increment has to be odd
+	State = 0;
+	Increment = (InSequence << 1) | 1;
+	Next();
+	State += InSeed;
+	Next();
+}
+
+uint32 FSimulationRandomStream::Next()
+{
+	const uint64 OldState = State;
+	State = OldState * 6364136223846793005ull + Increment;
+
+	const uint32 XorShifted = StaticCast<uint32>(((OldState >> 18) ^ OldState) >> 27);
+	const uint32 Rotation = StaticCast<uint32>(OldState >> 59);
+	return (XorShifted >> Rotation) | (XorShifted << ((32 - Rotation) & 31));
+}
+
+int32 FSimulationRandomStream::RandRange(int32 InMin, int32 InMax)
+{
+	if (InMax <= InMin)
+	{
+		return InMin;
+	}
+
+	// Lemire's multiply-and-shift, rejecting the few low values that would make the result biased
+	const uint32 Range = StaticCast<uint32>(InMax - InMin) + 1;
+	if (Range == 0)
+	{
+		return StaticCast<int32>(Next());
+	}
+
+	uint64 Product = StaticCast<uint64>(Next()) * Range;
+	uint32 Low = StaticCast<uint32>(Product);
+	if (Low < Range)
+	{
+		const uint32 Threshold = (0u - Range) % Range;
+		while (Low < Threshold)
+		{
+			Product = StaticCast<uint64>(Next()) * Range;
+			Low = StaticCast<uint32>(Product);
+		}
+	}
+	return InMin + StaticCast<int32>(Product >> 32);
+}
+
+float FSimulationRandomStream::GetFraction()
+{
+	// The 24 high bits fill the float mantissa exactly
+	return (Next() >> 8) * (1.f / 16777216.f);
+}
+
+float FSimulationRandomStream::FRandRange(float InMin, float InMax)
+{
+	return InMin + (InMax - InMin) * GetFraction();
+}
+
+FSimulationRandomStream FSimulationRandom::MakeStream(ESimulationRandomStream InStream, uint32 InSubStream) const
+{
+	const uint64 Sequence = (StaticCast<uint64>(InStream) << 32) | InSubStream;
+	return FSimulationRandomStream(MixSeed(StaticCast<uint64>(StaticCast<uint32>(RootSeed)) ^ MixSeed(Sequence)),
+	                               Sequence);
+}
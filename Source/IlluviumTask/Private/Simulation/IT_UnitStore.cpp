@@ -0,0 +1,39 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Simulation/IT_UnitStore.h"
+
+int32 FUnitStore::AddUnit(ETeam InTeam, const FIntPoint& InPosition, float InHealth, float InAttackPower,
+                          int32 InAttackRange)
+{
+	const int32 UnitId = Positions.Add(InPosition);
+	PreviousPositions.Add(InPosition);
+	Health.Add(InHealth);
+	AttackPower.Add(InAttackPower);
+	AttackRange.Add(InAttackRange);
+	Teams.Add(InTeam);
+	AliveMask.Add(true);
+	return UnitId;
+}
+
+void FUnitStore::Reset()
+{
+	Positions.Reset();
+	PreviousPositions.Reset();
+	Health.Reset();
+	AttackPower.Reset();
+	AttackRange.Reset();
+	Teams.Reset();
+	AliveMask.Reset();
+}
+
+void FUnitStore::Reserve(int32 InNumUnits)
+{
+	Positions.Reserve(InNumUnits);
+	PreviousPositions.Reserve(InNumUnits);
+	Health.Reserve(InNumUnits);
+	AttackPower.Reserve(InNumUnits);
+	AttackRange.Reserve(InNumUnits);
+	Teams.Reserve(InNumUnits);
+	AliveMask.Reserve(InNumUnits);
+}
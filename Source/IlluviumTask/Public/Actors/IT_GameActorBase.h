@@ -38,7 +38,13 @@ public:
 	void HandleZeroHealth();
 	void StartDestroy();
 
-	void MoveActorInterp(const FVector& InNewLocation, float InInterpTime_ms);
+	/**
+	 * Places the actor between two locations
+	 * @param InFromLocation Location at the start of the last simulation step
+	 * @param InToLocation Location at the end of the last simulation step
+	 * @param InAlpha Interpolation alpha in the [0;1] range
+	 */
+	void MoveActorInterp(const FVector& InFromLocation, const FVector& InToLocation, float InAlpha);
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Debug")
 	int32 GridPointIndex;
@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "StaticData.h"
+#include "IT_UnitInstancedRenderer.generated.h"
+
+class UInstancedStaticMeshComponent;
+struct FUnitStore;
+
+/**
+ * Draws all the units of a team through a single instanced static mesh.
+ * Every unit gets a fixed instance for the whole simulation, killed units are scaled to zero instead of being removed,
+ * so the instance indices never shift. The units move every turn, so a plain instanced mesh is used: it has no cluster
+ * tree to rebuild, and only the instances whose transforms changed are written.
+ */
+UCLASS()
+class ILLUVIUMTASK_API AIT_UnitInstancedRenderer : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AIT_UnitInstancedRenderer();
+
+	/**
+	 * Creates an instance for every unit of the store that has none yet
+	 * @param InUnits The unit store to visualize
+	 * @param InGridCellSize The size of grid cells for scaling to the world coordinates
+	 * @param InGridType The type of the grid, defines the layout of the cells in the world
+	 */
+	void AddUnits(const FUnitStore& InUnits, float InGridCellSize, EGridType InGridType);
+
+	/**
+	 * Updates the transforms of the instances from the unit store. Only the moving units and the ones that have just
+	 * stopped or died are written, the render state is marked dirty once per team
+	 * @param InUnits The unit store to visualize
+	 * @param InAlpha Interpolation alpha between the previous and the current unit positions
+	 */
+	void UpdateInstances(const FUnitStore& InUnits, float InAlpha);
+
+protected:
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="Mesh")
+	TObjectPtr<UStaticMesh> UnitMesh;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="Mesh")
+	TObjectPtr<UMaterialInterface> RedTeamMaterial;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="Mesh")
+	TObjectPtr<UMaterialInterface> BlueTeamMaterial;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Mesh")
+	TObjectPtr<UInstancedStaticMeshComponent> RedTeamInstances;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Mesh")
+	TObjectPtr<UInstancedStaticMeshComponent> BlueTeamInstances;
+
+private:
+	// The instances of an instanced component
+	struct FTeamInstances
+	{
+		// Unit id of each instance
+		TArray<int32> UnitIds;
+		// The transform last written to each instance
+		TArray<FTransform> Transforms;
+	};
+
+	UInstancedStaticMeshComponent* GetTeamInstances(ETeam InTeam) const;
+
+	FTransform GetUnitTransform(const FUnitStore& InUnits, int32 InUnitId, float InAlpha) const;
+
+	// The instances, per instanced component
+	TMap<TObjectPtr<UInstancedStaticMeshComponent>, FTeamInstances> TeamInstances;
+
+	// The number of units that already have an instance
+	int32 NumRegisteredUnits = 0;
+
+	float GridCellSize = 50.f;
+
+	EGridType GridType = EGridType::Rectangular;
+};
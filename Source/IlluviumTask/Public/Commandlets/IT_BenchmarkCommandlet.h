@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "IT_BenchmarkCommandlet.generated.h"
+
+class AIT_GameModeDefault;
+class UWorld;
+
+/**
+ * Times the hot parts of the simulation on fixed seeds and reports them as JSON, optionally failing on regressions
+ * against a previous report.
+ *
+ * Usage:
+ * UnrealEditor-Cmd IlluviumTask.uproject -run=IT_Benchmark -nullrhi -unattended
+ *		[-Seed=0] [-Iterations=10] [-MaxGridSize=4096] [-MaxUnits=100000] [-Json=Path/To/Report.json]
+ *		[-Baseline=Path/To/Previous.json] [-Threshold=0.1]
+ *
+ * The cases:
+ * GridInit_N: FGrid::Init of an NxN grid, N from 100 up to MaxGridSize
+ * Neighbors_Type: a FGrid::ForEachNeighbor sweep over all the points of a 1024x1024 grid
+ * FindPath_Map_Mode: IT_Pathfinder::FindPath between random points of a 256x256 open, maze or crowded map
+ * FindPath_Map_Hierarchical: IT_HierarchicalPathfinder::FindPath on the same queries, with the clusters built
+ * FindClosestActor_N: the closest opponent look-up with N units on the board, N from 1000 up to MaxUnits
+ * Turn_N: a full simulation turn with N units on the board
+ *
+ * Every case reports the median, the 99th percentile, the minimum and the mean of its samples in milliseconds, and
+ * the bytes allocated by the structures it exercises, as their GetAllocatedSize reports them. The process memory is
+ * not sampled, it is too noisy for the cases this small. With -Baseline, a case whose median is slower than the
+ * baseline's by more than the threshold fraction fails the run.
+ */
+UCLASS()
+class ILLUVIUMTASK_API UIT_BenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UIT_BenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	struct FBenchmarkSettings
+	{
+		int32 Seed = 0;
+		int32 Iterations = 10;
+		int32 MaxGridSize = 4096;
+		int32 MaxUnits = 100000;
+	};
+
+	struct FCaseResult
+	{
+		FString Name;
+		// Seconds per sample
+		TArray<double> Samples;
+		// The bytes allocated by the structures the case exercises
+		int64 MemoryBytes = 0;
+
+		/**
+		 * @param InPercentile In the [0;1] range
+		 * @return The nearest-rank percentile of the samples, in milliseconds
+		 */
+		double GetPercentileMs(double InPercentile) const;
+		double GetMeanMs() const;
+	};
+
+	void RunGridCases(const FBenchmarkSettings& InSettings, TArray<FCaseResult>& OutResults) const;
+	void RunPathCases(const FBenchmarkSettings& InSettings, TArray<FCaseResult>& OutResults) const;
+	void RunClosestActorCases(const FBenchmarkSettings& InSettings, TArray<FCaseResult>& OutResults) const;
+	void RunTurnCases(const FBenchmarkSettings& InSettings, TArray<FCaseResult>& OutResults) const;
+
+	/**
+	 * Creates a transient game world with a headless simulation in it, the units already spawned
+	 * @param OutWorld The created world, to be passed to DestroyGameWorld
+	 * @return The game mode, nullptr if it could not be spawned
+	 */
+	AIT_GameModeDefault* CreateGameWorld(int32 InGridSize, int32 InNumUnits, int32 InSeed, UWorld*& OutWorld) const;
+	void DestroyGameWorld(UWorld* InWorld) const;
+
+	/**
+	 * Compares the medians of the cases to the ones of the same name in the baseline report
+	 * @return false if the baseline could not be read or a case regressed beyond the threshold
+	 */
+	bool CompareToBaseline(const FString& InBaselinePath, double InThreshold,
+	                       const TArray<FCaseResult>& InResults) const;
+};
@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "IT_PathOracleCommandlet.generated.h"
+
+struct FGrid;
+
+/**
+ * Fuzzes the pathfinder against a reference search on random grids, and reports the mismatches and the speed.
+ *
+ * Usage:
+ * UnrealEditor-Cmd IlluviumTask.uproject -run=IT_PathOracle -nullrhi -unattended
+ *		[-Seed=0] [-Trials=1000] [-QueriesPerTrial=16] [-MinGridSize=4] [-MaxGridSize=64] [-MaxDensity=0.4]
+ *		[-Csv=Path/To/Queries.csv]
+ *
+ * Every trial makes a grid of a random size, topology, cell ordering and terrain, blocks a random fraction of its
+ * points and places the query starts and goals on points of their own, like the units. Several queries share a goal,
+ * so the batched queries are exercised too. Each variant's path is checked to be connected, to avoid the occupied and
+ * the blocked points and to cost the same as the one of the reference search, a plain Dijkstra (a BFS on the unit
+ * cost topologies without terrain).
+ * The hierarchical pathfinder is only near-optimal: its cost may exceed the reference one by its crossing slack for
+ * each cluster crossing of the reference path, see IT_HierarchicalPathfinder::GetCostBound. It finds a path whenever
+ * the reference does. The path cache variant occupies a point in the middle of each cached path and checks the
+ * repaired one: it keeps the prefix before that point, so it costs the prefix plus the reference cost of the rest.
+ * The random stream the trials are made with is first checked against the reference sequence of the PCG paper's demo.
+ * Trial N uses Seed + N, and a mismatch logs the trial's seed, so -Seed=<seed> -Trials=1 replays it.
+ * The run fails if there is any mismatch.
+ */
+UCLASS()
+class ILLUVIUMTASK_API UIT_PathOracleCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UIT_PathOracleCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	struct FOracleSettings
+	{
+		int32 Trials = 1000;
+		int32 QueriesPerTrial = 16;
+		int32 MinGridSize = 4;
+		int32 MaxGridSize = 64;
+		float MaxDensity = 0.4f;
+	};
+
+	// The totals of a pathfinder variant over all the trials
+	struct FVariantTotals
+	{
+		int32 Queries = 0;
+		int32 Mismatches = 0;
+		int64 Expansions = 0;
+		double Time = 0.0;
+	};
+
+	/**
+	 * Checks that FSimulationRandomStream gives the reference PCG32 sequence, so the seeds replay the same trials
+	 * @return false if a value differs
+	 */
+	static bool CheckRandomStream();
+
+	/**
+	 * Runs a single trial, checking every variant against the reference
+	 * @param InSeed The seed of the trial, selects everything about it
+	 * @param OutTotals The totals of each variant, added to
+	 * @param OutCsvLines Per-query records, added to
+	 */
+	void RunTrial(int32 InSeed, const FOracleSettings& InSettings, TArray<FVariantTotals>& OutTotals,
+	              TArray<FString>& OutCsvLines) const;
+
+	/**
+	 * The reference search. The occupied points block the paths, except for the goal
+	 * @param OutPath The shortest path, from the start to the goal. Empty if the goal can't be reached
+	 * @return The cost of the shortest path, a negative one if the goal can't be reached
+	 */
+	static float FindReferenceCost(const FGrid& InGrid, const FIntPoint& InStart, const FIntPoint& InGoal,
+	                               TArray<FIntPoint>& OutPath);
+
+	/**
+	 * Checks that the path leads from the start to the goal over the neighbor points, avoiding the occupied ones
+	 * @param OutCost The cost of the path
+	 * @param OutError What is wrong with the path
+	 * @return false if the path is broken
+	 */
+	static bool ValidatePath(const FGrid& InGrid, const FIntPoint& InStart, const FIntPoint& InGoal,
+	                         TConstArrayView<FIntPoint> InPath, float& OutCost, FString& OutError);
+};
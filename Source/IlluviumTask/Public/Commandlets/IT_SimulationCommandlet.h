@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "StaticData.h"
+#include "IT_SimulationCommandlet.generated.h"
+
+class AIT_GameModeDefault;
+
+/**
+ * Runs battles headless, as fast as possible, and reports the throughput, the path cache reuse and the winners.
+ *
+ * Usage:
+ * UnrealEditor-Cmd IlluviumTask.uproject -run=IT_Simulation -nullrhi -unattended
+ *		[-Seed=0] [-Battles=1] [-GridSizeX=100] [-GridSizeY=100] [-ActorsPerTeam=10] [-MaxTurns=100000]
+ *		[-GameMode=/Game/Blueprints/GameModes/BP_GameModeDefault.BP_GameModeDefault_C] [-Csv=Path/To/Report.csv]
+ *		[-SpawnActors]
+ *
+ * The units are simulated without actors unless -SpawnActors is passed.
+ * Add -trace=cpu,counters to record the turn phases and the simulation counters for Unreal Insights.
+ * Battle N uses Seed + N, so any battle of a sweep can be replayed on its own.
+ */
+UCLASS()
+class ILLUVIUMTASK_API UIT_SimulationCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UIT_SimulationCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	struct FBattleSettings
+	{
+		int32 Seed = 0;
+		int32 GridSizeX = 100;
+		int32 GridSizeY = 100;
+		int32 ActorsPerTeam = 10;
+		int32 MaxTurns = 100000;
+		bool bSpawnActors = false;
+	};
+
+	struct FBattleResult
+	{
+		int32 Seed = 0;
+		int32 Turns = 0;
+		double WallTime = 0.0;
+		double SpawnTime = 0.0;
+		double FlowFieldsTime = 0.0;
+		double PathsTime = 0.0;
+		double DecisionsTime = 0.0;
+		double ApplyTime = 0.0;
+		double CleanupTime = 0.0;
+		double EndCheckTime = 0.0;
+		// The path cache queries served by a valid cached path, by a repaired one and by a new search
+		int32 PathCacheHits = 0;
+		int32 PathCacheRepairs = 0;
+		int32 PathCacheMisses = 0;
+		ETeam Winner = ETeam::NoTeam;
+
+		double GetTurnsPerSecond() const
+		{
+			const double TurnsTime = FlowFieldsTime + PathsTime + DecisionsTime + ApplyTime + CleanupTime + EndCheckTime;
+			return TurnsTime > 0.0 ? Turns / TurnsTime : 0.0;
+		}
+	};
+
+	/**
+	 * Creates a transient game world, runs a single battle in it and destroys the world
+	 * @return false if the battle could not be set up
+	 */
+	bool RunBattle(TSubclassOf<AIT_GameModeDefault> InGameModeClass, const FBattleSettings& InSettings,
+	               FBattleResult& OutResult) const;
+};
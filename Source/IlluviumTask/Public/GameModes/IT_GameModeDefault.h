@@ -6,10 +6,59 @@
 #include "GameFramework/GameModeBase.h"
 #include "StaticData.h"
 #include "Grid/IT_Grid.h"
+#include "Grid/IT_FlowField.h"
+#include "Grid/IT_PathCache.h"
+#include "Grid/IT_SpatialIndex.h"
+#include "Simulation/IT_FixedStepScheduler.h"
+#include "Simulation/IT_SimulationRandom.h"
+#include "Simulation/IT_UnitStore.h"
 #include "IT_GameModeDefault.generated.h"
 
 
+class AIT_GameActorBase;
 class AIT_GridTestActor;
+class AIT_UnitInstancedRenderer;
+class UIT_TerrainMap;
+
+/**
+ * Accumulated wall time of the simulation phases, in seconds.
+ */
+struct FSimulationPhaseTimes
+{
+	double Spawn = 0.0;
+	double FlowFields = 0.0;
+	double Paths = 0.0;
+	double Decisions = 0.0;
+	double Apply = 0.0;
+	double Cleanup = 0.0;
+	double EndCheck = 0.0;
+	int32 NumTurns = 0;
+
+	double GetTurnsTotal() const
+	{
+		return FlowFields + Paths + Decisions + Apply + Cleanup + EndCheck;
+	}
+};
+
+/**
+ * What a unit decided to do during the decision phase of a turn.
+ */
+struct FUnitDecision
+{
+	enum class EAction : uint8
+	{
+		None,
+		Attack,
+		Move
+	};
+
+	EAction Action = EAction::None;
+	// The unit to attack
+	int32 TargetUnitId = INDEX_NONE;
+	// The grid point to move to
+	FIntPoint MoveCoordinates = FIntPoint::ZeroValue;
+};
+
 /**
  * 
  */
@@ -18,6 +67,9 @@ class ILLUVIUMTASK_API AIT_GameModeDefault : public AGameModeBase
 {
 	GENERATED_BODY()
 
+	// Times the private simulation steps directly
+	friend class UIT_BenchmarkCommandlet;
+
 public:
 	AIT_GameModeDefault(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
 
@@ -31,6 +83,48 @@ public:
 
 	UFUNCTION(BlueprintCallable)
 	void K2_StartSimulation();
+
+	// Headless simulation API, used to drive the battle without a level or a tick, see UIT_SimulationCommandlet.
+
+	/**
+	 * Overrides the game settings. Must be called on a deferred spawned game mode, before it finishes spawning
+	 * @param InGridSizeX The X size of grid to generate
+	 * @param InGridSizeY The Y size of grid to generate
+	 * @param InNumberOfActorsPerTeam The number of actors each team will have
+	 * @param InVisualizationMode How to visualize the units
+	 * @param InRandomSeed The root seed of the simulation random streams
+	 */
+	void SetupSimulation(int32 InGridSizeX, int32 InGridSizeY, int32 InNumberOfActorsPerTeam,
+	                     EUnitVisualizationMode InVisualizationMode, int32 InRandomSeed);
+
+	/**
+	 * Spawns the units and starts the simulation
+	 */
+	void StartHeadlessSimulation();
+
+	/**
+	 * Makes a single simulation turn
+	 * @return true while the simulation is ongoing
+	 */
+	bool StepSimulation();
+
+	bool IsSimulationOngoing() const;
+
+	/**
+	 * @return The only team that is left on the board, NoTeam while more than one team is left
+	 */
+	ETeam GetWinningTeam() const;
+
+	const FSimulationPhaseTimes& GetPhaseTimes() const;
+
+	// The cached paths of the Pathfinding navigation mode
+	const IT_PathCache& GetPathCache() const;
+
+	/**
+	 * @return The memory allocated for the simulation state: the grid, the units, the spatial index, the flow fields,
+	 * the path cache, the pathfinders and the planner, in bytes
+	 */
+	SIZE_T GetSimulationAllocatedSize() const;
 	
 protected:
 	
@@ -43,6 +137,18 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="GameSettings")
 	int32 GridSizeY = 100;
 
+	// The topology of the grid to generate
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="GameSettings")
+	EGridType GridType = EGridType::Rectangular;
+
+	// The order to store the grid points in, the tiled one keeps the neighbors closer in memory on the large grids
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="GameSettings")
+	EGridCellOrdering GridCellOrdering = EGridCellOrdering::RowMajor;
+
+	// The walls and the terrain costs of the map. The grid takes the size of the map, if there is one
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="GameSettings")
+	TObjectPtr<UIT_TerrainMap> TerrainMap;
+
 	// The size of grid cells for scaling to the world coordinates
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="GameSettings")
 	float GridCellSize = 50.f;
@@ -51,6 +157,11 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="GameSettings")
 	int32 NumberOfActorsPerTeam = 1;
 
+	// The root seed of all the simulation randomness, the same seed replays the same battle. A negative seed picks
+	// a new one on each run, the picked seed is logged
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="GameSettings")
+	int32 RandomSeed = 0;
+
 	// Generally, we don't need this variable, but for now I simply use it instead of magic numbers for spawning
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="GameSettings")
 	int32 NumberOfTeams = 2;
@@ -59,6 +170,14 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="GameSettings")
 	TSubclassOf<AIT_GameActorBase> ActorClass;
 
+	// How to visualize the units. The simulation itself runs on the unit data only
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="GameSettings")
+	EUnitVisualizationMode VisualizationMode = EUnitVisualizationMode::Actors;
+
+	// The renderer to be used in the Instanced visualization mode
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="GameSettings")
+	TSubclassOf<AIT_UnitInstancedRenderer> InstancedRendererClass;
+
 	// The subclass to be used for the simulation. It's just a single class at the moment tho
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="GameSettings")
 	TSubclassOf<AIT_GridTestActor> GridActorDummyClass;
@@ -75,17 +194,91 @@ protected:
 	// Maximum Health that will be used for random Health setup
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="GameSettings|ActorsSetting|Health")
 	float HealthPointsMax = 10.f;
-	// TimeStep duration that will be used for simulation.
+
+	// TimeStep duration that will be used for simulation, in seconds.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="GameSettings", meta=(ClampMin=0.001, Units="s"))
+	float SimulationTimeStep = 0.1f;
+
+	// The maximum number of simulation steps a single frame can catch up with. Time beyond it is dropped.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="GameSettings", meta=(ClampMin=1))
+	int32 MaxSimulationStepsPerFrame = 4;
+
+	// Defines how the units choose targets and moves. FlowField shares a single search per team each turn.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="GameSettings")
+	EUnitNavigationMode NavigationMode = EUnitNavigationMode::Greedy;
+
+	// The side of the spatial index buckets in grid cells, used for the closest opponent look-ups
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="GameSettings", meta=(ClampMin=1))
+	int32 SpatialIndexBucketSize = 8;
+
+	// The side of the hierarchical pathfinder clusters in grid cells. Larger clusters give shorter paths and slower
+	// rebuilds
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="GameSettings", meta=(ClampMin=2))
+	int32 PathClusterSize = 16;
+
+	// The Pathfinding navigation mode answers the queries longer than this many grid cells with the hierarchical
+	// pathfinder on the game thread. Its paths are near-optimal and much cheaper to find. 0 disables it
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="GameSettings", meta=(ClampMin=0))
+	int32 HierarchicalPathDistance = 0;
+
+	// The search algorithm of the Pathfinding navigation mode
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="GameSettings")
+	EPathSearchMode PathSearchMode = EPathSearchMode::JumpPoint;
+
+	// The side of the goal regions of the path cache in grid cells. A cached path is repaired while its target moves
+	// inside the region, and searched again once the target leaves it
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="GameSettings", meta=(ClampMin=1))
+	int32 PathCacheRegionSize = 4;
+
+	// Runs the path searches on the worker threads. The units follow the valid part of their cached paths, or step
+	// greedily, until the results arrive on the next turn
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="GameSettings")
-	float SimulationTimeStep_ms = 0.1f;
+	bool bAsyncPathfinding = true;
+
+	// The maximum number of path searches started each turn in the async pathfinding, the rest wait for the next turns
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="GameSettings", meta=(ClampMin=1))
+	int32 MaxPathRequestsPerTurn = 64;
+
+	// The number of turns the units plan and reserve ahead in the Cooperative navigation mode
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="GameSettings", meta=(ClampMin=1))
+	int32 CooperativeWindow = 8;
+
+	// Runs the decision phase of the turns across the worker threads. The outcome is the same either way.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="GameSettings")
+	bool bParallelDecisions = true;
 	
 
 private:
 	/**
-	 * Simple Actor spawning method
+	 * Simple unit spawning method
 	 */
 	void SpawnActors();
 
+	/**
+	 * Adds a unit with random stats to the unit store and registers it on the grid
+	 * @param InTeam The team of the unit
+	 * @param InCoordinates Grid coordinates of the unit. The point is expected to be empty
+	 * @param InActorClass The class of the visual actor, only used in the Actors visualization mode
+	 * @return Id of the added unit
+	 */
+	int32 AddUnit(ETeam InTeam, const FIntPoint& InCoordinates, TSubclassOf<AIT_GameActorBase> InActorClass);
+
+	/**
+	 * Spawns the visual actor of a unit
+	 */
+	void SpawnUnitActor(int32 InUnitId, TSubclassOf<AIT_GameActorBase> InActorClass);
+
+	/**
+	 * Spawns the instanced renderer, if there is none yet, and adds all the units to it
+	 */
+	void SpawnInstancedRenderer();
+
+	/**
+	 * Places the unit visuals between their previous and current grid positions
+	 * @param InAlpha Interpolation alpha in the [0;1] range
+	 */
+	void UpdateUnitVisuals(float InAlpha);
+
 	/**
 	 * Starts the simulation
 	 */
@@ -99,23 +292,81 @@ private:
 
 	/**
 	 * Or rather a Step, not a turn.. A simulation iteration functional unit.
+	 * All the units decide on their actions against the grid as it was at the start of the turn, then the actions are
+	 * applied in the unit id order, see ApplyDecisions.
 	 */
 	void MakeSimulationTurn();
 
+	/**
+	 * Decides on the unit's action for this turn. Doesn't change the simulation state, so it's safe to call for
+	 * several units at once
+	 * @param InActionUnitId The unit to decide for
+	 * @return The decided action
+	 */
+	FUnitDecision DecideUnitAction(int32 InActionUnitId) const;
+
+	/**
+	 * Applies the decisions of all the units. Attacks are simultaneous, so a unit killed this turn still hits.
+	 * Moves go after the kills, and a grid point claimed by several units goes to the one with the lowest id.
+	 */
+	void ApplyDecisions();
+
 	/**
 	 * Find the closest opponent
-	 * @param InActor An actor to look opponents for
+	 * @param InUnitId A unit to look opponents for
 	 * @param OutDistanceSqr Square distance to the found opponent 
-	 * @return Pointer to the found opponent
+	 * @return Id of the found opponent, INDEX_NONE if there are none
 	 */
-	AIT_GameActorBase* FindClosestActor(AIT_GameActorBase* InActor, int32& OutDistanceSqr);
+	int32 FindClosestActor(int32 InUnitId, int32& OutDistanceSqr) const;
 	
-	void ActorAttack(AIT_GameActorBase* InTargetActor, AIT_GameActorBase* InInstigatorActor);
+	/**
+	 * Deals the attacker's damage to the target
+	 * @return true if this attack brought the target's health down to zero
+	 */
+	bool ActorAttack(int32 InTargetUnitId, int32 InActionUnitId);
 
-	FIntPoint GetNextMoveLocation(AIT_GameActorBase* InActionActor, AIT_GameActorBase* InTargetActor, const FGrid& InGrid);
-	void ActorMoveTowards(AIT_GameActorBase* InTargetActor, AIT_GameActorBase* InInstigatorActor);
+	/**
+	 * Finds an empty neighbor grid point that is closer to the target than the unit is
+	 * @param OutCoordinates The found grid point
+	 * @return false if there is no such point
+	 */
+	bool GetNextMoveLocation(int32 InActionUnitId, int32 InTargetUnitId, const FGrid& InGrid,
+	                         FIntPoint& OutCoordinates) const;
 
-	void HandleActorKilled(AIT_GameActorBase* InTargetActor, AIT_GameActorBase* InInstigatorActor);
+	/**
+	 * Moves the unit to the grid point and updates the Grid accordingly
+	 * @param InUnitId The unit to move
+	 * @param InNewCoordinates The grid coordinates to move to. The point is expected to be empty
+	 */
+	void MoveActorTo(int32 InUnitId, const FIntPoint& InNewCoordinates);
+
+	/**
+	 * Builds a flow field for each team, flowing towards all the living opponents of the team
+	 */
+	void BuildFlowFields();
+
+	/**
+	 * Decides on the unit's attack or move using its team's flow field
+	 * @param InActionUnitId The unit to decide for
+	 * @param OutDecision The decided action
+	 * @return false if the flow field can't provide a valid action, so the unit has to fall back to the greedy search
+	 */
+	bool DecideFlowFieldAction(int32 InActionUnitId, FUnitDecision& OutDecision) const;
+
+	/**
+	 * Finds the next path step of each living unit that is out of the attack range of its closest opponent.
+	 * The synchronous searches share the pathfinder, so this runs before the parallel decisions. They are batched by
+	 * the target. In the async pathfinding it collects the searches of the previous turn and dispatches the new ones
+	 */
+	void FindPathSteps();
+
+	/**
+	 * Plans the next step of each living unit that is out of the attack range of its closest opponent, in the id
+	 * order, so the units don't block each other. The units in range keep their points
+	 */
+	void PlanCooperativeSteps();
+
+	void HandleActorKilled(int32 InTargetUnitId, int32 InInstigatorUnitId);
 	
 	/**
 	 * A conversion method to receive Global coordinates from the Grid Coordinates
@@ -131,13 +382,40 @@ private:
 	void TestGrid();
 
 	// TODO: Move it to GameState.
-	// An array of Game Actors.
-	TArray<class AIT_GameActorBase*> GameActors;
+	// The simulation state of all the units
+	FUnitStore Units;
+
+	// The visual actors of the units, indexed by the unit id. Only used in the Actors visualization mode
+	UPROPERTY()
+	TArray<TObjectPtr<AIT_GameActorBase>> UnitActors;
+
+	// Draws the units in the Instanced visualization mode
+	UPROPERTY()
+	TObjectPtr<AIT_UnitInstancedRenderer> InstancedRenderer;
 
 	TMap<ETeam, int32> ActorsNumPerTeam;
 
-	// An array of Game Actors pending to be destroyed.
-	TArray<class AIT_GameActorBase*> KilledGameActors;
+	// The number of units that are still alive
+	int32 NumLivingUnits = 0;
+
+	// Per-team index of the units' grid positions, for the closest opponent look-ups
+	IT_SpatialIndex SpatialIndex;
+
+	// Flow fields towards the opponents of each team. Rebuilt every turn in the FlowField navigation mode
+	TMap<ETeam, IT_FlowField> FlowFields;
+
+	// The paths of the units in the Pathfinding navigation mode
+	IT_PathCache PathCache;
+
+	// The next path step of each unit for the current turn, FIntPoint::NoneValue if there is none. In the Cooperative
+	// navigation mode the unit's own point means it waits
+	TArray<FIntPoint> PathSteps;
+
+	// The decisions of the current turn, indexed by the unit id
+	TArray<FUnitDecision> Decisions;
+
+	// Units killed during the current turn, their actors are destroyed at the end of it.
+	TArray<int32> KilledUnits;
 
 	// The grid
 	FGrid Grid;
@@ -145,8 +423,25 @@ private:
 	// A bool flag to check if simulation is active
 	bool bSimulationOngoing = false;
 
-	// A counter to accumulate delta time from ticks to simulate TimeSteps
-	float TimeStepAccumulator = 0.f;
+	// Turns the tick time into fixed simulation steps
+	FFixedStepScheduler StepScheduler;
+
+	// The random streams of the spawn points and the unit stats, derived from the RandomSeed
+	FSimulationRandom Random;
+	FSimulationRandomStream SpawnRandom;
+	FSimulationRandomStream StatsRandom;
+
+	FSimulationPhaseTimes PhaseTimes;
 
 	TPimplPtr<class IT_Pathfinder> Pathfinder;
+
+	// Long-range queries, see HierarchicalPathDistance. Only created if enabled. Kept in sync with the grid occupancy,
+	// its clusters are rebuilt lazily
+	TPimplPtr<class IT_HierarchicalPathfinder> HierarchicalPathfinder;
+
+	// Runs the path searches of the async pathfinding, only created in the Pathfinding navigation mode if enabled
+	TPimplPtr<class IT_PathRequestQueue> PathRequests;
+
+	// Plans the moves of the Cooperative navigation mode, only created in that mode
+	TPimplPtr<class IT_CooperativePlanner> CooperativePlanner;
 };
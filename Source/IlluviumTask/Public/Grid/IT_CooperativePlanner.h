@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IT_Pathfinder.h"
+#include "IT_ReservationTable.h"
+
+struct FGrid;
+
+/**
+ * Cooperative path planning in the manner of windowed hierarchical cooperative A* (WHCA*).
+ * Every turn the units plan one after another with a space-time A* over (point, turn) for a short window of turns.
+ * A unit may wait or move to a neighbor each turn. Its plan avoids the points reserved by the units planned before it,
+ * and never swaps places with one of them. The plan is then reserved, so the next units plan around it.
+ * Beyond the window the heuristic stands in for the rest of the path, and the plans are made again every turn.
+ * A unit moves at most one point per turn, so a search only reaches the points around its start. The search state
+ * is sized for those and keyed by the touched (point, turn) pairs, never by the whole Grid times the window.
+ */
+class ILLUVIUMTASK_API IT_CooperativePlanner
+{
+public:
+	/**
+	 * Init the planner
+	 * @param InGrid The grid to plan on, must outlive the planner
+	 * @param InWindow The number of turns planned ahead
+	 */
+	void Init(const FGrid& InGrid, int32 InWindow);
+
+	/**
+	 * Drops the reservations of the previous turn
+	 */
+	void BeginTurn();
+
+	/**
+	 * Reserves the point of a unit that doesn't move this turn for the whole window
+	 */
+	void ReserveStationary(int32 InUnitId, const FIntPoint& InCoordinates);
+
+	/**
+	 * Reserves the point of a unit that is going to plan its moves for the current turn only, so the units planned
+	 * before it may follow it
+	 */
+	void ReserveStart(int32 InUnitId, const FIntPoint& InCoordinates);
+
+	/**
+	 * Plans the unit's moves for the window and reserves them
+	 * @param InUnitId The unit to plan for
+	 * @param InStart Current coordinates of the unit
+	 * @param InGoal Coordinates of the goal, usually occupied by the target
+	 * @param OutNextStep The point to move to on this turn. The unit's own point if it waits. The point may still be
+	 * occupied by a unit that leaves it this turn
+	 * @return false if there is no plan, the unit then waits and keeps its point for the window
+	 */
+	bool PlanUnit(int32 InUnitId, const FIntPoint& InStart, const FIntPoint& InGoal, FIntPoint& OutNextStep);
+
+	/**
+	 * @return The memory allocated for the reservations and the search state, in bytes
+	 */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	// A point of the Grid at a turn of the window
+	struct FSpaceTimeNode
+	{
+		int32 Index;
+		int32 Time;
+	};
+
+	/**
+	 * @return The search node of the point at the time, added if the current search hasn't touched it yet
+	 */
+	int32 FindOrAddNode(int32 InIndex, int32 InTime);
+
+	const FGrid* Grid = nullptr;
+	IT_ReservationTable Reservations;
+
+	// Search state keyed by the search node, see FindOrAddNode
+	Path::FSearchScratch Scratch;
+
+	// The (point, turn) pairs touched by the current search, by the search node
+	TArray<FSpaceTimeNode> Nodes;
+	// Search node by Time * Grid->Num() + Index
+	TMap<int64, int32> NodeIds;
+
+	// The search nodes of the last plan, from the start on
+	TArray<int32> PlanNodes;
+};
@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IT_Grid.h"
+
+/**
+ * A flow field (Dijkstra map) over the Grid.
+ * A multi-source BFS from a set of source points stores, for every reached point, the number of steps to
+ * the closest source, the next point on the way to it and the source itself.
+ * Occupied points receive values, but the search doesn't pass through them, so a unit standing on the grid
+ * can look up its own point while other units still block the way.
+ */
+class ILLUVIUMTASK_API IT_FlowField
+{
+public:
+	/**
+	 * Rebuild the field
+	 * @param InGrid The grid to build the field on
+	 * @param InSourceIndices Grid point indices the field flows to
+	 */
+	void Build(const FGrid& InGrid, TConstArrayView<int32> InSourceIndices);
+
+	/**
+	 * @return Steps from the point to the closest source, INDEX_NONE if no source can be reached
+	 */
+	int32 GetDistance(int32 InIndex) const
+	{
+		return Distances.IsValidIndex(InIndex) ? Distances[InIndex] : INDEX_NONE;
+	}
+
+	/**
+	 * @return The next point on the way to the closest source, INDEX_NONE for sources and unreachable points
+	 */
+	int32 GetNextIndex(int32 InIndex) const
+	{
+		return NextIndices.IsValidIndex(InIndex) ? NextIndices[InIndex] : INDEX_NONE;
+	}
+
+	/**
+	 * @return The closest source of the point, INDEX_NONE if no source can be reached
+	 */
+	int32 GetSourceIndex(int32 InIndex) const
+	{
+		return SourceIndices.IsValidIndex(InIndex) ? SourceIndices[InIndex] : INDEX_NONE;
+	}
+
+	/**
+	 * @return The memory allocated for the field, in bytes
+	 */
+	SIZE_T GetAllocatedSize() const
+	{
+		return Distances.GetAllocatedSize() + NextIndices.GetAllocatedSize() + SourceIndices.GetAllocatedSize()
+			+ Frontier.GetAllocatedSize();
+	}
+
+private:
+	TArray<int32> Distances;
+	TArray<int32> NextIndices;
+	TArray<int32> SourceIndices;
+
+	// BFS queue, kept between builds to avoid reallocation
+	TArray<int32> Frontier;
+};
@@ -3,6 +3,9 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "StaticData.h"
+
+struct FSimulationRandomStream;
 
 /*struct ILLUVIUMTASK_API IT_GridCell
 {
@@ -44,25 +47,85 @@ public:
 	~IT_GridGenerator();
 };*/
 
-enum class EGridType
+/*
+ * We may use the rules of the Grid formation, like: Rect, Hex, Oct. Which will define the directions in which to check if there is a node
+ * NW NN NE | [-1;-1]	[0;-1]	[1;-1]
+ * WW OO EE | [-1;0]	[0;0]	[1;0]
+ * SW SS SE | [-1;1]	[0;1]	[1;1]
+ * Rect: NN, WW, EE, SS connections, each costs 1.
+ * Hex: NW, NE, WW, EE, SW, SE connections, each costs 1. The odd rows are shifted by half a point to the right
+ * ("odd-r" layout), so the diagonal connections of the even and odd rows point to different columns.
+ * Oct: All 8 directions, the diagonal ones cost the square root of 2.
+ *
+ * To check: if the coordinates of interest are in bounds of the Grid size and are not below zero
+ * 0 <= X <= Grid.Size.X
+ * 0 <= Y <= Grid.Size.Y
+ */
+// Grid point coordinates modifiers for neighbors look-up. Resolved at compile time, see FGrid::ForEachNeighbor.
+struct FGridModifier
+{
+	int32 X;
+	int32 Y;
+	float Cost;
+};
+
+template <EGridType InGridType>
+struct TGridModifiers;
+
+template <>
+struct TGridModifiers<EGridType::Rectangular>
+{
+	static constexpr FGridModifier Modifiers[]{{1, 0, 1.f}, {-1, 0, 1.f}, {0, 1, 1.f}, {0, -1, 1.f}};
+};
+
+template <>
+struct TGridModifiers<EGridType::Hexagonal>
+{
+	static constexpr FGridModifier EvenRowModifiers[]
+		{{1, 0, 1.f}, {-1, 0, 1.f}, {-1, -1, 1.f}, {0, -1, 1.f}, {-1, 1, 1.f}, {0, 1, 1.f}};
+	static constexpr FGridModifier OddRowModifiers[]
+		{{1, 0, 1.f}, {-1, 0, 1.f}, {0, -1, 1.f}, {1, -1, 1.f}, {0, 1, 1.f}, {1, 1, 1.f}};
+};
+
+template <>
+struct TGridModifiers<EGridType::Octagonal>
+{
+	static constexpr FGridModifier Modifiers[]
+	{
+		{-1, 1, UE_SQRT_2}, {0, 1, 1.f}, {1, 1, UE_SQRT_2}, {-1, 0, 1.f},
+		{1, 0, 1.f}, {-1, -1, UE_SQRT_2}, {0, -1, 1.f}, {1, -1, UE_SQRT_2}
+	};
+};
+//--
+
+/**
+ * A neighbor of a grid point, see FGrid::ForEachNeighbor.
+ */
+struct FGridNeighbor
 {
-	None,
-	Rectangular,
-	Hexagonal,
-	Octagonal
+	FIntPoint Coordinates;
+	int32 Index;
+	// The cost of moving from the point to this neighbor
+	float Cost;
 };
 
 /**
- * The struct to represent a grid element.
+ * The struct to represent a grid element. The grid doesn't store it, it's built on demand from the point index.
  */
 struct ILLUVIUMTASK_API FGridPoint
 {
 	FIntPoint GridCoords;
-	TObjectPtr<class AIT_GameActorBase> GameActor = nullptr;
+	// Id of the unit occupying the point, see FUnitStore. INDEX_NONE if the point is empty
+	int32 UnitId = INDEX_NONE;
 	int32 Index = 0;
 	
 	FString GetDebugString() const;
 
+	bool IsOccupied() const
+	{
+		return UnitId != INDEX_NONE;
+	}
+
 	bool operator==(const FGridPoint& InPoint) const
 	{
 		return GridCoords == InPoint.GridCoords;
@@ -71,6 +134,7 @@ struct ILLUVIUMTASK_API FGridPoint
 
 /**
  * The struct (but rather a class already) to represent the grid.
+ * Only the id of the unit occupying each point is stored, so the hot occupancy checks touch 4 bytes per point.
  */
 struct ILLUVIUMTASK_API FGrid
 {
@@ -78,64 +142,384 @@ struct ILLUVIUMTASK_API FGrid
 	 * Init Grid
 	 * @param InSizeX Size of the X side of the Grid 
 	 * @param InSizeY Size of the Y side of the Grid
+	 * @param InGridType Topology of the Grid
+	 * @param InCellOrdering The order to store the points in
+	 */
+	void Init(int32 InSizeX, int32 InSizeY, EGridType InGridType = EGridType::Rectangular,
+	          EGridCellOrdering InCellOrdering = EGridCellOrdering::RowMajor);
+
+	/*
+	 * The terrain is the static layer of the Grid, set once before the units are added. Each point has a cost, the
+	 * multiplier of the connection costs in the 1/16ths: the regular ground is 16, a road at half the cost is 8, mud
+	 * at three times the cost is 48. A cost of 0 blocks the point for good, like a wall.
+	 * A connection costs its topology cost times the average of the costs of its two points, so the costs stay
+	 * symmetric. The blocked points are never visited as neighbors and never count as empty, while the units stay
+	 * in their own dynamic layer.
+	 */
+	static constexpr uint8 BlockedTerrainCost = 0;
+	static constexpr uint8 DefaultTerrainCost = 16;
+
+	/**
+	 * Sets the terrain costs. Expected to be called before any unit is added
+	 * @param InTerrainCosts The cost of each point, row after row regardless of the cell ordering
+	 */
+	void SetTerrain(TConstArrayView<uint8> InTerrainCosts);
+
+	uint8 GetTerrainCost(int32 Index) const
+	{
+		return TerrainCosts[Index];
+	}
+
+	bool IsBlocked(int32 Index) const
+	{
+		return TerrainCosts[Index] == BlockedTerrainCost;
+	}
+
+	bool IsBlocked(const FIntPoint& Coordinates) const
+	{
+		return IsBlocked(GetIndex(Coordinates));
+	}
+
+	/**
+	 * @return true if all the points that are not blocked have the default cost, so the connections cost what their
+	 * topology says
 	 */
-	void Init(int32 InSizeX, int32 InSizeY, EGridType InGridType = EGridType::Rectangular);
+	bool HasUniformTerrain() const
+	{
+		return bUniformTerrain;
+	}
+
+	/**
+	 * @return The multiplier of the topology cost of the connection between the neighbor points
+	 */
+	float GetConnectionScale(int32 FromIndex, int32 ToIndex) const
+	{
+		return (TerrainCosts[FromIndex] + TerrainCosts[ToIndex]) * HalfTerrainScale;
+	}
 
 	void PrintGrid() const;
 
 	/**
-	 * A getter for the Grid Array
-	 * @return GridArray
+	 * @return The number of points on the Grid
 	 */
-	const TArray<FGridPoint>& GetGrid() const;
+	int32 Num() const
+	{
+		return UnitIds.Num();
+	}
 
 	/**
 	 * Get Grid element at index
 	 * @param Index Element index
 	 * @return Element at index
 	 */
-	FGridPoint& At(int32 Index);
+	FGridPoint At(int32 Index) const;
 
 	/**
 	 * Get Grid element by coordinates
 	 * @param Coordinates Element coordinates
 	 * @return Element at coordinates
 	 */
-	FGridPoint& At(FIntPoint Coordinates);
+	FGridPoint At(FIntPoint Coordinates) const;
 
 	/**
-	 * Get Grid element by coordinates. Constant version
-	 * @param Coordinates Element coordinates
-	 * @return Element at coordinates
+	 * @param Coordinates Point coordinates, expected to be on the Grid
+	 * @return Index of the point
+	 */
+	int32 GetIndex(const FIntPoint& Coordinates) const
+	{
+		if (CellOrdering == EGridCellOrdering::Tiled)
+		{
+			return GetTiledIndex(Coordinates);
+		}
+		return Coordinates.X + (Coordinates.Y * SizeX);
+	}
+
+	/**
+	 * @param Index Point index
+	 * @return Coordinates of the point
+	 */
+	FIntPoint GetCoordinates(int32 Index) const
+	{
+		if (CellOrdering == EGridCellOrdering::Tiled)
+		{
+			return GetTiledCoordinates(Index);
+		}
+		return FIntPoint{Index % SizeX, Index / SizeX};
+	}
+
+	/**
+	 * @return Id of the unit occupying the point, INDEX_NONE if the point is empty
+	 */
+	int32 GetUnitId(int32 Index) const
+	{
+		return UnitIds[Index];
+	}
+
+	bool IsOccupied(int32 Index) const
+	{
+		return UnitIds[Index] != INDEX_NONE;
+	}
+
+	bool IsOccupied(const FIntPoint& Coordinates) const
+	{
+		return IsOccupied(GetIndex(Coordinates));
+	}
+
+	/**
+	 * @return The number of times the point has switched between empty and occupied. Lets the cached searches check
+	 * whether the point may have changed since they last saw it
 	 */
-	const FGridPoint& At(FIntPoint Coordinates) const;
+	uint32 GetOccupancyVersion(int32 Index) const
+	{
+		return OccupancyVersions[Index];
+	}
+
+	/**
+	 * Puts the unit on the point, or clears the point
+	 * @param Coordinates Point coordinates
+	 * @param InUnitId Id of the unit, INDEX_NONE to clear the point
+	 */
+	void SetUnitId(const FIntPoint& Coordinates, int32 InUnitId);
+
+	/**
+	 * Copies the unit ids and the occupancy versions of another grid, keeping the terrain. Costs far less than a full
+	 * copy, for the snapshots read off the game thread. The empty points are not tracked by the copy, so only the
+	 * occupancy queries and the searches are valid on it
+	 * @param InGrid The grid to copy, of the same size, type, cell ordering and terrain
+	 */
+	void CopyOccupancy(const FGrid& InGrid);
 	
 	/**
+	 * @return The number of the empty points
+	 */
+	int32 NumEmpty() const
+	{
+		return EmptyIndices.Num();
+	}
+
+	/**
+	 * @return The memory allocated for the points, in bytes
+	 */
+	SIZE_T GetAllocatedSize() const
+	{
+		return UnitIds.GetAllocatedSize() + OccupancyVersions.GetAllocatedSize() + TerrainCosts.GetAllocatedSize()
+			+ EmptyIndices.GetAllocatedSize() + EmptyPositions.GetAllocatedSize();
+	}
+
+	/**
+	* Picks a random empty point in constant time. The point stays empty until a unit is put on it
+	* @param InRandom The stream to draw from
 	* @return Returns a random position on Grid that is not yet occupied
 	*/
-	bool FindRandomEmptyPointOnGrid(FGridPoint& OutGridPoint) const;
+	bool FindRandomEmptyPointOnGrid(FSimulationRandomStream& InRandom, FGridPoint& OutGridPoint) const;
 
 	/**
+	* @param InRandom The stream to draw from
 	* @return Returns a random position on Grid
 	*/
-	FGridPoint FindRandomPointOnGrid(int32& OutRandomIndex) const;
+	FGridPoint FindRandomPointOnGrid(FSimulationRandomStream& InRandom, int32& OutRandomIndex) const;
 
 	EGridType GetGridType() const;
 
-	TArray<FGridPoint> GetNodeConnections(const FGridPoint& Point) const;
+	EGridCellOrdering GetCellOrdering() const
+	{
+		return CellOrdering;
+	}
+
+	int32 GetSizeX() const
+	{
+		return SizeX;
+	}
+
+	int32 GetSizeY() const
+	{
+		return SizeY;
+	}
+
+	/**
+	 * The lowest possible cost of moving between two points on a Grid without obstacles, an admissible A* heuristic:
+	 * the Manhattan distance on the rectangular grids, the octile distance on the octagonal ones and the cube distance
+	 * on the hexagonal ones
+	 * @param From Coordinates of the first point
+	 * @param To Coordinates of the second point
+	 * @return The distance
+	 */
+	float GetDistance(const FIntPoint& From, const FIntPoint& To) const;
+
+	/**
+	 * The distance scaled by the lowest terrain cost, so it never overestimates the cost of a path over the terrain
+	 * @return A lower bound of the cost of moving between the points
+	 */
+	float GetCostEstimate(const FIntPoint& From, const FIntPoint& To) const
+	{
+		return GetDistance(From, To) * MinTerrainScale;
+	}
+
+	/**
+	 * @return The highest terrain cost of a point that is not blocked, as a multiplier of the topology costs
+	 */
+	float GetMaxTerrainScale() const
+	{
+		return MaxTerrainScale;
+	}
+
+	/**
+	 * Converts the Grid coordinates into the layout coordinates, in the Grid points. Only differs from the Grid
+	 * coordinates on the hexagonal Grids, where the odd rows are shifted and the rows are packed closer
+	 * @param InGridType The type of the Grid
+	 * @param Coordinates The Grid coordinates
+	 * @return The layout coordinates
+	 */
+	static FVector2D GetLayoutPosition(EGridType InGridType, const FIntPoint& Coordinates);
+
+	/**
+	 * Calls the visitor for each neighbor of the point that is on the Grid. Doesn't allocate anything
+	 * @param Coordinates The point to visit the neighbors of
+	 * @param Visitor Called as Visitor(const FGridNeighbor& Neighbor)
+	 */
+	template <typename FVisitor>
+	void ForEachNeighbor(const FIntPoint& Coordinates, FVisitor&& Visitor) const
+	{
+		switch (GridType)
+		{
+		case EGridType::Rectangular:
+			VisitNeighbors<EGridType::Rectangular>(Coordinates, Visitor);
+			break;
+		case EGridType::Hexagonal:
+			VisitNeighbors<EGridType::Hexagonal>(Coordinates, Visitor);
+			break;
+		case EGridType::Octagonal:
+			VisitNeighbors<EGridType::Octagonal>(Coordinates, Visitor);
+			break;
+		default:
+			break;
+		}
+	}
 
 	bool IsPointOnGrid(const FIntPoint& Point) const;
 
-	// These two methods should be called before and after the spawning of actors
-	// TODO: consider moving the spawning functionality to under the grid responsibility, or under some generator class
-	void OnStartSpawningActors();
-	void OnFinishSpawningActors();
 private:
-	TArray<FGridPoint> GridArray;
+	/*
+	 * The tiled ordering stores the tiles row after row, and each tile's points one after another. The full tiles keep
+	 * their points in the Morton order, interleaving the bits of the local X (even bits) and Y (odd bits). The tiles
+	 * cut by the right and bottom edges are smaller and keep theirs row after row, so no padding is needed and the
+	 * indices stay in [0;Num()).
+	 */
+	static constexpr int32 TileSizeLog2 = 3;
+	static constexpr int32 TileSize = 1 << TileSizeLog2;
+
+	// Spreads the 3 low bits to the even bits
+	static int32 SpreadTileBits(int32 Value)
+	{
+		return (Value & 1) | ((Value & 2) << 1) | ((Value & 4) << 2);
+	}
+
+	// Gathers the even bits to the 3 low bits
+	static int32 CompactTileBits(int32 Value)
+	{
+		return (Value & 1) | ((Value >> 1) & 2) | ((Value >> 2) & 4);
+	}
+
+	int32 GetTiledIndex(const FIntPoint& Coordinates) const
+	{
+		const int32 TileX = Coordinates.X >> TileSizeLog2;
+		const int32 TileY = Coordinates.Y >> TileSizeLog2;
+		const int32 LocalX = Coordinates.X & (TileSize - 1);
+		const int32 LocalY = Coordinates.Y & (TileSize - 1);
+		const int32 TileWidth = FMath::Min(TileSize, SizeX - (TileX << TileSizeLog2));
+		const int32 TileHeight = FMath::Min(TileSize, SizeY - (TileY << TileSizeLog2));
+
+		const int32 TileStart = (TileY << TileSizeLog2) * SizeX + (TileX << TileSizeLog2) * TileHeight;
+		if (TileWidth == TileSize && TileHeight == TileSize)
+		{
+			return TileStart + (SpreadTileBits(LocalX) | (SpreadTileBits(LocalY) << 1));
+		}
+		return TileStart + LocalX + LocalY * TileWidth;
+	}
+
+	FIntPoint GetTiledCoordinates(int32 Index) const
+	{
+		const int32 TileY = Index / (SizeX << TileSizeLog2);
+		const int32 TileHeight = FMath::Min(TileSize, SizeY - (TileY << TileSizeLog2));
+		int32 Local = Index - TileY * (SizeX << TileSizeLog2);
+
+		const int32 TileX = Local / (TileHeight << TileSizeLog2);
+		const int32 TileWidth = FMath::Min(TileSize, SizeX - (TileX << TileSizeLog2));
+		Local -= TileX * (TileHeight << TileSizeLog2);
+
+		const FIntPoint TileOrigin{TileX << TileSizeLog2, TileY << TileSizeLog2};
+		if (TileWidth == TileSize && TileHeight == TileSize)
+		{
+			return TileOrigin + FIntPoint{CompactTileBits(Local), CompactTileBits(Local >> 1)};
+		}
+		return TileOrigin + FIntPoint{Local % TileWidth, Local / TileWidth};
+	}
+
+	template <EGridType InGridType, typename FVisitor>
+	void VisitNeighbors(const FIntPoint& Coordinates, FVisitor& Visitor) const
+	{
+		const auto VisitModifiers = [this, &Coordinates, &Visitor](const auto& Modifiers)
+		{
+			// The terrain costs are only looked up when they differ
+			const float Scale = bUniformTerrain ? 0.f : TerrainCosts[GetIndex(Coordinates)] * HalfTerrainScale;
+			for (const FGridModifier& Modifier : Modifiers)
+			{
+				const FIntPoint NeighborCoordinates{Coordinates.X + Modifier.X, Coordinates.Y + Modifier.Y};
+				if (!IsPointOnGrid(NeighborCoordinates))
+				{
+					continue;
+				}
+
+				const int32 NeighborIndex = GetIndex(NeighborCoordinates);
+				const uint8 NeighborCost = TerrainCosts[NeighborIndex];
+				if (NeighborCost == BlockedTerrainCost)
+				{
+					continue;
+				}
+
+				const float Cost = bUniformTerrain
+					                   ? Modifier.Cost
+					                   : Modifier.Cost * (Scale + NeighborCost * HalfTerrainScale);
+				Visitor(FGridNeighbor{NeighborCoordinates, NeighborIndex, Cost});
+			}
+		};
+
+		if constexpr (InGridType == EGridType::Hexagonal)
+		{
+			if (Coordinates.Y & 1)
+			{
+				VisitModifiers(TGridModifiers<InGridType>::OddRowModifiers);
+			}
+			else
+			{
+				VisitModifiers(TGridModifiers<InGridType>::EvenRowModifiers);
+			}
+		}
+		else
+		{
+			VisitModifiers(TGridModifiers<InGridType>::Modifiers);
+		}
+	}
+
+	// Id of the unit occupying each point, INDEX_NONE for the empty ones
+	TArray<int32> UnitIds;
+	// Occupancy change counter of each point
+	TArray<uint32> OccupancyVersions;
+	// Terrain cost of each point, see SetTerrain
+	TArray<uint8> TerrainCosts;
+	bool bUniformTerrain = true;
+	// The lowest terrain cost of a point that is not blocked, as a multiplier
+	float MinTerrainScale = 1.f;
+	// The highest terrain cost of a point that is not blocked, as a multiplier
+	float MaxTerrainScale = 1.f;
+	static constexpr float HalfTerrainScale = 0.5f / DefaultTerrainCost;
 	int32 SizeX = 0;
 	int32 SizeY = 0;
 	EGridType GridType = EGridType::None;
+	EGridCellOrdering CellOrdering = EGridCellOrdering::RowMajor;
 
-	// Should be populated before and cleared after the spawning stage 
-	mutable TArray<FGridPoint> EmptyPoints;
+	// Indices of the empty points, in no particular order. Removing one swaps the last one into its place
+	TArray<int32> EmptyIndices;
+	// Position of each point in EmptyIndices, INDEX_NONE for the occupied and the blocked ones
+	TArray<int32> EmptyPositions;
 };
\ No newline at end of file
@@ -0,0 +1,238 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IT_Pathfinder.h"
+
+struct FGrid;
+
+/**
+ * Hierarchical path-finding (HPA*) over the Grid, for the long-range queries.
+ * The Grid is split into square clusters. Wherever two clusters touch with empty points on both sides, entrances are
+ * placed, and the costs between the entrances of every cluster are precomputed. A query searches this small abstract
+ * graph first, then refines only the segments it needs with searches bounded by a single cluster.
+ * Occupancy changes only mark their cluster as dirty, the dirty clusters are rebuilt on the next query.
+ *
+ * The abstract graph is complete, so a path is found whenever there is one, and the whole grid is never searched:
+ * - the empty straight neighbors on the two sides of a border form runs, each with an entrance in the middle or at
+ *   both ends;
+ * - the diagonal neighbors squeezed between two obstacles, with no common neighbor to step through, are entrances of
+ *   their own;
+ * - the start and the end of a query connect to the entrances of every cluster they neighbor, so their own crossings,
+ *   which are occupied by the units, need no entrance.
+ *
+ * The queries inside a single cluster are exact when no path leaving the cluster can be shorter than the one inside
+ * it. The other queries are near-optimal: every other crossing of an optimal path adds at most GetCrossingSlack to
+ * the cost. A straight crossing moves along the border to the nearest entrance of its run and back, and an unsqueezed
+ * diagonal one turns into two straight steps through a common neighbor, crossing one or two straight borders. See
+ * GetCostBound.
+ */
+class ILLUVIUMTASK_API IT_HierarchicalPathfinder
+{
+public:
+	/**
+	 * Init the pathfinder. The clusters are built on the first query
+	 * @param InGrid The grid to search, must outlive the pathfinder
+	 * @param InClusterSize Size of the cluster side in grid points
+	 */
+	void Init(const FGrid& InGrid, int32 InClusterSize);
+
+	/**
+	 * Marks the cluster of the point for rebuilding. Must be called whenever the occupancy of the point changes
+	 * @param InCoordinates The changed point
+	 */
+	void MarkDirty(const FIntPoint& InCoordinates);
+
+	/**
+	 * Finds a near-optimal path, see the class comment
+	 * @param InStartNode The node to start from
+	 * @param InEndNode The node to reach, may be occupied
+	 * @return The path, including the start and the end nodes. Empty if there is none
+	 */
+	TArray<Path::FNode> FindPath(const Path::FNode& InStartNode, const Path::FNode& InEndNode);
+
+	/**
+	 * @return The most a crossing of the clusters on an optimal path can add to the cost of the found path:
+	 * (4 * D + 2) times the highest terrain scale, D being the farthest a point of an entrance run is from the nearest
+	 * entrance of the run
+	 */
+	float GetCrossingSlack() const;
+
+	/**
+	 * The highest cost FindPath may return for the points of an optimal path, see the class comment
+	 * @param InOptimalPath An optimal path on the current grid, from the start to the end
+	 * @param InOptimalCost The cost of the optimal path
+	 * @return The optimal cost plus the slack of each of its cluster crossings that isn't an entrance
+	 */
+	float GetCostBound(TConstArrayView<FIntPoint> InOptimalPath, float InOptimalCost) const;
+
+	/**
+	 * @return The memory allocated for the clusters, the abstract graph and the search state, in bytes
+	 */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	// A pair of neighbor points on the border of two clusters
+	struct FEntrance
+	{
+		// Grid index of the point in the cluster the border belongs to
+		int32 Index = INDEX_NONE;
+		// Grid index of the point across the border, in the +X or the +Y cluster, or a diagonal one
+		int32 NeighborIndex = INDEX_NONE;
+		int32 NeighborClusterId = INDEX_NONE;
+		// The cost of the step between the points
+		float Cost = 0.f;
+		// Positions of the points in the EntranceIndices of their clusters, set when the clusters are rebuilt
+		int32 Slot = INDEX_NONE;
+		int32 NeighborSlot = INDEX_NONE;
+	};
+
+	// A point of the abstract path
+	struct FWaypoint
+	{
+		FIntPoint Coordinates;
+		// The cluster the segment to the waypoint is searched in, INDEX_NONE for a step between two entrances
+		int32 ClusterId = INDEX_NONE;
+	};
+
+	// An edge from the start or to the end of the query
+	struct FQueryEdge
+	{
+		int32 Node = INDEX_NONE;
+		float Cost = 0.f;
+	};
+
+	// The clusters a point steps into first: its own one and the ones of its neighbors
+	using FHomeClusterIds = TArray<int32, TInlineAllocator<4>>;
+
+	struct FCluster
+	{
+		// Min is inclusive, Max is exclusive
+		FIntRect Bounds;
+		// Grid indices of the entrance points inside the cluster
+		TArray<int32> EntranceIndices;
+		// Costs between the entrances, EntranceIndices.Num() squared. TNumericLimits<float>::Max() if not connected
+		TArray<float> Distances;
+	};
+
+	int32 GetClusterId(const FIntPoint& InCoordinates) const;
+
+	/**
+	 * @return true if the point is on the grid, empty and not blocked
+	 */
+	bool IsWalkable(const FIntPoint& InCoordinates) const;
+
+	/**
+	 * Calls the visitor for each entrance with a point in the cluster, as
+	 * Visitor(FEntrance& Entrance, bool bIsOwnBorder, int32 OtherClusterId). The point is the Index of the entrances on
+	 * the cluster's own borders, and the NeighborIndex of the others
+	 */
+	template <typename FVisitor>
+	void ForEachEntrance(int32 InClusterId, FVisitor&& Visitor);
+
+	void GetHomeClusters(const FIntPoint& InCoordinates, FHomeClusterIds& OutClusterIds) const;
+
+	/**
+	 * Finds the costs from the point to the entrances of its home clusters, the costs are symmetric
+	 * @param OutEdges The abstract graph nodes of the reached entrances with their costs, added to
+	 */
+	void ConnectToEntrances(int32 InIndex, const FHomeClusterIds& InHomeClusterIds, TArray<FQueryEdge>& OutEdges);
+
+	/**
+	 * Finds the path on the abstract graph into Waypoints
+	 * @param InStart The point to start from
+	 * @param InEnd The point to reach, may be occupied
+	 * @return false if there is no path
+	 */
+	bool FindAbstractPath(const FIntPoint& InStart, const FIntPoint& InEnd);
+
+	/**
+	 * Refines a segment of the abstract path into grid points
+	 * @param InFrom The first point of the segment
+	 * @param InTo The end of the segment
+	 * @param OutPath The points of the segment, except InFrom, are appended to it
+	 * @return false if the segment can't be passed
+	 */
+	bool RefineSegment(const FIntPoint& InFrom, const FWaypoint& InTo, TArray<Path::FNode>& OutPath);
+
+	/**
+	 * Appends the path found by the last bounded search, except its first point
+	 */
+	void AppendBoundedPath(const FIntRect& InBounds, const FIntPoint& InFrom, const FIntPoint& InTo,
+	                       TArray<Path::FNode>& OutPath) const;
+
+	/**
+	 * @return The lowest possible cost of a path between the points of the bounds that leaves the bounds
+	 */
+	float GetLeavingCostEstimate(const FIntRect& InBounds, const FIntPoint& InStart, const FIntPoint& InEnd) const;
+
+	void RebuildDirtyClusters();
+
+	/**
+	 * Places the entrances on the border between the cluster and its neighbors in the direction
+	 */
+	void RebuildBorder(int32 InClusterId, const FIntPoint& InDirection);
+
+	/**
+	 * Collects the entrances of the cluster and computes the costs between them
+	 */
+	void RebuildCluster(int32 InClusterId);
+
+	/**
+	 * Numbers the entrances of all the clusters as the nodes of the abstract graph
+	 */
+	void NumberAbstractNodes();
+
+	/**
+	 * Runs A*, or Dijkstra if there is no goal, from the start point without leaving the bounds. The start and the goal
+	 * may also be on the ring of points around the bounds
+	 * @param InBounds The bounds of the search, no larger than a cluster
+	 * @param InStartIndex Grid index of the point to start from
+	 * @param InGoalIndex Grid index of the point to reach, may be occupied. INDEX_NONE to reach every point
+	 * @return true if the goal is reached
+	 */
+	bool SearchBounded(const FIntRect& InBounds, int32 InStartIndex, int32 InGoalIndex);
+
+	/**
+	 * @return The cost of the point found by the last bounded search, TNumericLimits<float>::Max() if it's not reached
+	 */
+	float GetBoundedCost(const FIntRect& InBounds, int32 InIndex) const;
+
+	int32 ToLocalIndex(const FIntRect& InBounds, const FIntPoint& InCoordinates) const;
+	FIntPoint ToCoordinates(const FIntRect& InBounds, int32 InLocalIndex) const;
+
+	const FGrid* Grid = nullptr;
+	int32 ClusterSize = 0;
+	int32 ClustersX = 0;
+	int32 ClustersY = 0;
+
+	TArray<FCluster> Clusters;
+	// The border between the cluster and the one to its +X side, by cluster id
+	TArray<TArray<FEntrance>> BordersX;
+	// The border between the cluster and the one to its +Y side, by cluster id
+	TArray<TArray<FEntrance>> BordersY;
+
+	TArray<int32> DirtyClusterIds;
+	TBitArray<> DirtyClusters;
+
+	// The abstract graph node of the first entrance of each cluster, the others follow in the EntranceIndices order
+	TArray<int32> ClusterFirstNodes;
+	// The cluster of each abstract graph node
+	TArray<int32> NodeClusterIds;
+
+	// Search state of the bounded searches, keyed by the point index inside the bounds and their ring
+	Path::FSearchScratch Scratch;
+
+	// Search state of the abstract searches, keyed by the abstract graph node. The start and the end of the query
+	// follow the entrances
+	Path::FSearchScratch AbstractScratch;
+
+	// The edges of the query's start and end, reused by every query
+	TArray<FQueryEdge> StartEdges;
+	TArray<FQueryEdge> EndEdges;
+	// The cost from each abstract graph node to the query's end. Only the nodes of the EndEdges are set
+	TArray<float> EndNodeCosts;
+	// See FindAbstractPath
+	TArray<FWaypoint> Waypoints;
+};
@@ -0,0 +1,134 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FGrid;
+
+/**
+ * Keeps the last path of every unit, so the units chasing the same target don't search for it from scratch each turn.
+ * A unit follows its cached path while the goal stays in the same region and the remaining points stay empty.
+ * The points are checked against the Grid occupancy versions, so only the points that have changed since the path
+ * was found are looked at. When a point is blocked, or the goal moves inside its region, only the broken suffix of
+ * the path is searched again. The searches run elsewhere, the cache only says where they start from, see
+ * FindCachedStep and ApplySuffix.
+ */
+class ILLUVIUMTASK_API IT_PathCache
+{
+public:
+	/**
+	 * Init the cache, dropping all the paths
+	 * @param InNumUnits The number of units to keep the paths for
+	 * @param InRegionSize Side of the goal regions in grid points. The path is repaired while the goal stays in the
+	 * region it was found for, and searched from scratch once the goal leaves it
+	 */
+	void Init(int32 InNumUnits, int32 InRegionSize);
+
+	/**
+	 * Finds the next point on the unit's cached path without searching. The valid prefix of a broken path is still
+	 * followed while the rest of it is searched elsewhere, see ApplySuffix. A unit that has stepped off its path next
+	 * to it, e.g. moving greedily while the path was searched, rejoins it
+	 * @param OutNextStep The point to step to
+	 * @param OutSearchFrom The point the path has to be searched again from, FIntPoint::NoneValue if it is valid
+	 * @return false if the cached path doesn't provide a step
+	 */
+	bool FindCachedStep(int32 InUnitId, const FIntPoint& InStart, const FIntPoint& InGoal, const FGrid& InGrid,
+	                    FIntPoint& OutNextStep, FIntPoint& OutSearchFrom);
+
+	/**
+	 * Replaces the unit's path after the first point of the suffix with the suffix, or the whole path if the unit's
+	 * path doesn't pass that point anymore
+	 * @param InPoints The path found elsewhere, from the point it was searched from to the goal
+	 * @param InVersions Occupancy versions of the points on the grid the path was found on
+	 */
+	void ApplySuffix(int32 InUnitId, TConstArrayView<FIntPoint> InPoints, TConstArrayView<uint32> InVersions);
+
+	/**
+	 * @param OutNextStep The point after the unit's point on its path, as of the last FindCachedStep and ApplySuffix
+	 * @return false if there is none
+	 */
+	bool GetNextStep(int32 InUnitId, FIntPoint& OutNextStep) const;
+
+	/**
+	 * @return The points of the unit's cached path, from the point it was found from to the goal. Empty if it has none
+	 */
+	TConstArrayView<FIntPoint> GetPath(int32 InUnitId) const
+	{
+		return Entries.IsValidIndex(InUnitId) ? TConstArrayView<FIntPoint>(Entries[InUnitId].Points)
+			       : TConstArrayView<FIntPoint>();
+	}
+
+	/**
+	 * Drops the unit's path, e.g. once the unit is killed
+	 */
+	void Invalidate(int32 InUnitId);
+
+	// The number of queries served by a valid cached path, by a repaired one and by a new search
+	int32 GetNumHits() const
+	{
+		return NumHits;
+	}
+
+	int32 GetNumRepairs() const
+	{
+		return NumRepairs;
+	}
+
+	int32 GetNumMisses() const
+	{
+		return NumMisses;
+	}
+
+	/**
+	 * @return The memory allocated for the paths, in bytes
+	 */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	struct FEntry
+	{
+		// The path points, from the point the path was found from to the goal
+		TArray<FIntPoint> Points;
+		// Occupancy version of each point when it was last seen empty
+		TArray<uint32> Versions;
+		// Index of the unit's current point in Points
+		int32 Cursor = INDEX_NONE;
+	};
+
+	FEntry& GetEntry(int32 InUnitId);
+
+	/**
+	 * Moves the cursor to the unit's point and checks the rest of the path. Starts a new path if the unit has left it
+	 * and can't rejoin it, or if the goal has left its region
+	 * @return Index of the point the path has to be searched again from, INDEX_NONE if the path is valid
+	 */
+	int32 ValidatePath(FEntry& InEntry, const FIntPoint& InStart, const FIntPoint& InGoal, const FGrid& InGrid);
+
+	/**
+	 * Puts the unit that is off its path back on it, at the point furthest along among the unit's neighbors. The
+	 * points before it are replaced with the unit's point
+	 * @return Index of the unit's point in Points, INDEX_NONE if the unit is not next to the rest of the path
+	 */
+	static int32 RejoinPath(FEntry& InEntry, const FIntPoint& InStart, const FGrid& InGrid);
+
+	/**
+	 * Replaces the points of the entry after the given one with the suffix, which starts at that point.
+	 * INDEX_NONE replaces all the points
+	 */
+	static void SpliceSuffix(FEntry& InEntry, int32 InFromPoint, TConstArrayView<FIntPoint> InPoints,
+	                         TConstArrayView<uint32> InVersions);
+
+	FIntPoint GetRegion(const FIntPoint& InCoordinates) const
+	{
+		return FIntPoint{InCoordinates.X / RegionSize, InCoordinates.Y / RegionSize};
+	}
+
+	// Indexed by the unit id
+	TArray<FEntry> Entries;
+	int32 RegionSize = 1;
+
+	int32 NumHits = 0;
+	int32 NumRepairs = 0;
+	int32 NumMisses = 0;
+};
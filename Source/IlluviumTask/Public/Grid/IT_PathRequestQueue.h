@@ -0,0 +1,129 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IT_Grid.h"
+#include "IT_Pathfinder.h"
+#include "Tasks/Task.h"
+
+/**
+ * A path search requested by a unit.
+ */
+struct FPathRequest
+{
+	int32 UnitId = INDEX_NONE;
+	FIntPoint Start;
+	FIntPoint Goal;
+};
+
+/**
+ * A finished path search.
+ */
+struct FPathResult
+{
+	int32 UnitId = INDEX_NONE;
+	// The path from the start to the goal, empty if there is none
+	TArray<FIntPoint> Points;
+	// Occupancy version of each point on the grid snapshot the path was found on
+	TArray<uint32> Versions;
+};
+
+/**
+ * Runs the path searches off the game thread.
+ * The requests are queued on the game thread and dispatched in batches, no more than the budget per dispatch.
+ * The grid is copied into a snapshot once on Init, a dispatch only copies its occupancy over the snapshot and splits
+ * the batch between the worker tasks, each with its own pathfinder. The requests sharing a goal stay on one worker,
+ * which answers them with a single batched search.
+ * The results are collected on the game thread before the next dispatch, so the searches overlap with the rest of the
+ * simulation turn and never see the grid changing under them.
+ */
+class ILLUVIUMTASK_API IT_PathRequestQueue
+{
+public:
+	IT_PathRequestQueue() = default;
+	~IT_PathRequestQueue();
+
+	/**
+	 * Init the queue, dropping all the requests
+	 * @param InGrid The grid to search on. Only its occupancy may change afterwards
+	 * @param InMaxRequestsPerDispatch The budget of a single dispatch, the rest of the requests wait for the next one
+	 * @param InNumWorkers The number of worker tasks a dispatch is split between
+	 * @param InSearchMode The search algorithm
+	 */
+	void Init(const FGrid& InGrid, int32 InMaxRequestsPerDispatch, int32 InNumWorkers,
+	          EPathSearchMode InSearchMode);
+
+	/**
+	 * Queues a search. A unit can only have one request queued or running at a time
+	 * @return false if the unit already has one
+	 */
+	bool Submit(const FPathRequest& InRequest);
+
+	/**
+	 * @return true if the unit has a request queued or running
+	 */
+	bool IsPending(int32 InUnitId) const
+	{
+		return PendingUnits.IsValidIndex(InUnitId) && PendingUnits[InUnitId];
+	}
+
+	/**
+	 * Drops the unit's request. Its result is discarded if the search is already running
+	 */
+	void Cancel(int32 InUnitId);
+
+	/**
+	 * Launches the searches of the queued requests that fit the budget against a snapshot of the grid occupancy.
+	 * Expects the previous dispatch to be collected
+	 * @param InGrid The grid to search on, the one the queue was initialized with
+	 */
+	void Dispatch(const FGrid& InGrid);
+
+	/**
+	 * Waits for the searches of the last dispatch and hands out their results
+	 * @param OutResults The results are appended to it
+	 */
+	void Collect(TArray<FPathResult>& OutResults);
+
+	/**
+	 * @return The number of requests waiting for a dispatch
+	 */
+	int32 GetNumQueued() const
+	{
+		return Queue.Num() - QueueHead;
+	}
+
+	/**
+	 * @return The memory allocated for the queue, the snapshot and the workers' search state, in bytes
+	 */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	struct FWorker
+	{
+		IT_Pathfinder Pathfinder;
+		TArray<FPathRequest> Requests;
+		TArray<FPathResult> Results;
+		// The number of points closed by the worker's searches of the last dispatch
+		int32 NumExpanded = 0;
+		UE::Tasks::FTask Task;
+	};
+
+	void WaitForWorkers();
+
+	TArray<TUniquePtr<FWorker>> Workers;
+
+	// The requests waiting for a dispatch are the ones from QueueHead on
+	TArray<FPathRequest> Queue;
+	int32 QueueHead = 0;
+	// Indexed by the unit id
+	TBitArray<> PendingUnits;
+
+	// The workers only read the snapshot, it is not touched until they are collected. The terrain is copied on Init,
+	// each dispatch copies only the occupancy
+	FGrid Snapshot;
+
+	int32 MaxRequestsPerDispatch = 0;
+	EPathSearchMode SearchMode = EPathSearchMode::AStar;
+};
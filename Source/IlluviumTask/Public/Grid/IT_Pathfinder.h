@@ -10,9 +10,6 @@ struct FGrid;
 
 namespace Path
 {
-	struct FConnection;
-	struct FNodeRecord;
-
 	struct FNode
 	{
 		FIntPoint XY;
@@ -24,116 +21,151 @@ namespace Path
 		}
 	};
 
-	struct FConnection
+	/**
+	 * A single query of the batched search, see IT_Pathfinder::FindPaths.
+	 */
+	struct FQuery
 	{
-		FNode NodeFrom;
-		FNode NodeTo;
-		float ConnectionCost = 0.f;
-
-		FNodeRecord* From = nullptr;
-		FNodeRecord* To = nullptr;
+		FIntPoint Start;
+		FIntPoint Goal;
 	};
 
-	struct FNodeRecord
+	/**
+	 * A binary min-heap of grid point indices with decrease-key support.
+	 * The position of every index in the heap is tracked, so updating a discovered node doesn't require a search.
+	 */
+	class FOpenList
 	{
-		FNodeRecord()
+	public:
+		void Init(int32 InNumPoints);
+
+		bool IsEmpty() const
 		{
-		};
+			return Heap.Num() == 0;
+		}
 
-		FNodeRecord(const FNode& InNode)
+		bool Contains(int32 InIndex) const
 		{
-			Node = InNode;
+			return HeapPositions[InIndex] != INDEX_NONE;
 		}
 
-		FConnection ParentConnection;
-		float HeuristicValue = 0.f;
-		float CostSoFar = 0.f;
-		float EstimatedTotalCost = 0.f;
-		FNode Node;
-		TSharedRef<FNodeRecord> ParentNodeRef;
-		FNodeRecord* ParentNodePtr;
-	};
+		void Push(int32 InIndex, float InEstimatedTotalCost, float InCostSoFar);
 
-	using FNodeRecordPtr = TSharedPtr<Path::FNodeRecord>;
-	typedef TUniquePtr<Path::FNodeRecord> FNodeRecordUPtr;
+		/** Lowers the estimated total cost of an index that is already in the list. */
+		void DecreaseKey(int32 InIndex, float InEstimatedTotalCost, float InCostSoFar);
 
-	enum EVisitStatus
-	{
-		Unvisited = 0,
-		Discovered = 1,
-		Visited = 2
-	};
+		/** Removes and returns the index with the lowest estimated total cost. */
+		int32 Pop();
 
-	struct FNodeRecord2
-	{
-		FNodeRecord2()
-		{
-			VisitStatus = Unvisited;
-		};
+		/** Empties the list. Costs only as much as the number of entries left in it. */
+		void Reset();
 
-		FNodeRecord2(const FNode& InNode, EVisitStatus InVisitStatus = Unvisited)
+		SIZE_T GetAllocatedSize() const
 		{
-			Node = InNode;
-			VisitStatus = InVisitStatus;
+			return Heap.GetAllocatedSize() + HeapPositions.GetAllocatedSize();
 		}
-		~FNodeRecord2()
+
+	private:
+		struct FEntry
 		{
-			UE_LOG(LogTask, Display, TEXT("Node Record for %s is deconstructed."), *Node.XY.ToString());
-		}
+			int32 Index = INDEX_NONE;
+			float EstimatedTotalCost = 0.f;
+			float CostSoFar = 0.f;
+
+			// On equal estimates prefer the deeper node, it is closer to the goal.
+			bool operator<(const FEntry& InEntry) const
+			{
+				return EstimatedTotalCost < InEntry.EstimatedTotalCost
+					|| (EstimatedTotalCost == InEntry.EstimatedTotalCost && CostSoFar > InEntry.CostSoFar);
+			}
+		};
 
-		FConnection ParentConnection;
-		float HeuristicValue = 0.f;
-		float CostSoFar = 0.f;
-		float EstimatedTotalCost = 0.f;
-		FNode Node;
-		FNodeRecord2* ParentNodePtr = nullptr;
-		EVisitStatus VisitStatus;
+		void SiftUp(int32 HeapPosition);
+		void SiftDown(int32 HeapPosition);
+		void Place(const FEntry& InEntry, int32 HeapPosition);
+
+		TArray<FEntry> Heap;
+		// Grid point index -> position in the Heap array, INDEX_NONE if not in the list.
+		TArray<int32> HeapPositions;
 	};
 
-	struct FHeuristic
+	/**
+	 * Search state of a single query, stored in flat arrays keyed by the grid point index.
+	 * The arrays are allocated once per grid and reused across queries. Only the entries touched by a query are reset.
+	 */
+	struct FSearchScratch
 	{
-		FHeuristic() = delete;
+		void Init(int32 InNumPoints);
 
-		FHeuristic(const FNode& InEndNode)
+		/** Resets the entries touched by the previous query. */
+		void Reset();
+
+		int32 Num() const
 		{
-			EndNode = InEndNode;
+			return CostSoFar.Num();
 		}
 
-		float Estimate(const FNode& InStartNode) const
+		/** Marks the index as discovered by the current query. */
+		void Discover(int32 InIndex, float InCostSoFar, int32 InParentIndex);
+
+		/**
+		 * Discovers the index and pushes it to the open list, or lowers its cost if the new one is lower
+		 * @param InIndex The index to relax
+		 * @param InCostSoFar Cost of reaching the index through the parent
+		 * @param InParentIndex The index it is reached from
+		 * @param InEstimate Heuristic estimate of the remaining cost
+		 */
+		void Relax(int32 InIndex, float InCostSoFar, int32 InParentIndex, float InEstimate);
+
+		bool IsDiscovered(int32 InIndex) const
 		{
-			return FIntPoint(EndNode.XY - InStartNode.XY).SizeSquared();
+			return DiscoveredSet[InIndex];
 		}
 
-		static float Estimate(const FNode& InStartNode, const FNode& InEndNode)
+		SIZE_T GetAllocatedSize() const
 		{
-			return FIntPoint(InEndNode.XY - InStartNode.XY).SizeSquared();
+			return CostSoFar.GetAllocatedSize() + ParentIndices.GetAllocatedSize() + DiscoveredSet.GetAllocatedSize()
+				+ ClosedSet.GetAllocatedSize() + TouchedIndices.GetAllocatedSize() + OpenList.GetAllocatedSize();
 		}
 
-	private:
-		FNode EndNode;
+		TArray<float> CostSoFar;
+		TArray<int32> ParentIndices;
+		TBitArray<> DiscoveredSet;
+		TBitArray<> ClosedSet;
+		TArray<int32> TouchedIndices;
+		FOpenList OpenList;
+
+		// The number of points closed by the current query
+		int32 NumExpanded = 0;
 	};
 
 	/**
-	* A predicate class for pushing NodeRecords to the heapified open and closed lists.
-	*/
-	struct LessDistancePredicate
+	 * Estimates the cost to the end node with the distance matching the grid topology, scaled by the cheapest terrain,
+	 * see FGrid::GetCostEstimate. It never overestimates, so A* returns the optimal paths.
+	 */
+	struct FHeuristic
 	{
-		bool operator()(FNodeRecord LeftRecord, FNodeRecord RightRecord) const
-		{
-			return LeftRecord.EstimatedTotalCost < RightRecord.EstimatedTotalCost;
-		};
+		FHeuristic() = delete;
 
-		bool operator()(FNodeRecord* LeftRecord, FNodeRecord* RightRecord) const
+		FHeuristic(const FGrid& InGrid, const FNode& InEndNode)
+			: Grid(InGrid)
+			, EndNode(InEndNode)
 		{
-			return LeftRecord->EstimatedTotalCost < RightRecord->EstimatedTotalCost;
-		};
+		}
 
-		bool operator()(const FNodeRecord2& LeftRecord, const FNodeRecord2& RightRecord) const;
+		float Estimate(const FNode& InStartNode) const
+		{
+			return Grid.GetCostEstimate(InStartNode.XY, EndNode.XY);
+		}
 
-		bool operator()(const FNodeRecordUPtr& LeftRecord, const FNodeRecordUPtr& RightRecord) const
+		static float Estimate(const FGrid& InGrid, const FNode& InStartNode, const FNode& InEndNode)
 		{
-			return LeftRecord->EstimatedTotalCost < RightRecord->EstimatedTotalCost;
-		};
+			return InGrid.GetCostEstimate(InStartNode.XY, InEndNode.XY);
+		}
+
+	private:
+		const FGrid& Grid;
+		FNode EndNode;
 	};
 
 	struct FGraph
@@ -143,8 +175,19 @@ namespace Path
 		{
 		}
 
-		TArray<FConnection> GetNodeConnections(const FNodeRecord& InNodeRecord) const;
-		TArray<FNode> GetNodeConnections(const FNode& InNode) const;
+		/**
+		 * Calls the visitor for each node connected to the given one. Doesn't allocate anything
+		 * @param InNode The node to visit the connections of
+		 * @param Visitor Called as Visitor(const FNode& ConnectedNode, int32 ConnectedIndex, float ConnectionCost)
+		 */
+		template <typename FVisitor>
+		void ForEachNodeConnection(const FNode& InNode, FVisitor&& Visitor) const
+		{
+			GridRef.ForEachNeighbor(InNode.XY, [this, &Visitor](const FGridNeighbor& Neighbor)
+			{
+				Visitor(FNode{Neighbor.Coordinates, !GridRef.IsOccupied(Neighbor.Index)}, Neighbor.Index, Neighbor.Cost);
+			});
+		}
 
 		const FGrid& GridRef;
 	};
@@ -160,12 +203,86 @@ public:
 
 	void InitGraph(const FGrid& InGrid);
 
-	TArray<Path::FNode> FindPath(const Path::FNode& StartNode, const Path::FNode& EndNode);
+	/**
+	 * Finds the shortest path between two nodes. The end node may be occupied, e.g. by the target unit
+	 * @param StartNode The node to start from
+	 * @param EndNode The node to reach
+	 * @param InSearchMode The search algorithm. Both give paths of the same cost, JumpPoint falls back to AStar on
+	 * the hexagonal grids and on the terrain of varying costs
+	 * @return The path, including the start and the end nodes. Empty if there is none
+	 */
+	TArray<Path::FNode> FindPath(const Path::FNode& StartNode, const Path::FNode& EndNode,
+	                             EPathSearchMode InSearchMode = EPathSearchMode::AStar);
+
+	/**
+	 * Finds the shortest paths of many queries at once. The queries are grouped by the goal, and each group sharing
+	 * a goal is answered by a single reverse search from it, which stops once every start of the group is settled.
+	 * The groups of a single query run the regular FindPath
+	 * @param InQueries The queries. The goals may be occupied, e.g. by the target unit, the starts usually are
+	 * @param InSearchMode The search algorithm of the single queries
+	 * @return The path of each query, in the order of the queries. Empty if there is none
+	 */
+	TArray<TArray<Path::FNode>> FindPaths(TConstArrayView<Path::FQuery> InQueries,
+	                                      EPathSearchMode InSearchMode = EPathSearchMode::AStar);
+
+	/**
+	 * @return The number of points closed by the last FindPath or FindPaths call, over all of its searches
+	 */
+	int32 GetNumExpanded() const
+	{
+		return NumExpanded;
+	}
+
+	/**
+	 * Publishes the expansions of the finished searches to the trace counters. The searches running on the worker
+	 * threads are summed up per worker and published once they are collected, so the counters are only written from
+	 * the game thread
+	 * @param InNumSearches The number of the searches
+	 * @param InNumExpanded The number of points they closed in total
+	 */
+	static void TraceExpanded(int32 InNumSearches, int32 InNumExpanded);
+
+	/**
+	 * @return The memory allocated for the search state, in bytes
+	 */
+	SIZE_T GetAllocatedSize() const
+	{
+		return Scratch.GetAllocatedSize() + BatchStarts.GetAllocatedSize();
+	}
+
 	TArray<Path::FNode> GetNeighbors(const Path::FNode& InNode);
 	void VisualizePath(UWorld* World, TArray<Path::FNode> Array, float GridScale);
 
 	~IT_Pathfinder();
 
 private:
+	/**
+	 * Runs A* from the start index that is already in the open list
+	 * @return true if the end index is reached
+	 */
+	bool SearchAStar(const FGrid& InGrid, int32 InEndIndex, const Path::FHeuristic& InHeuristic);
+
+	/**
+	 * Runs the jump point search from the start index that is already in the open list, see FJumpPointGrid
+	 * @return true if the end index is reached
+	 */
+	bool SearchJumpPoints(const FGrid& InGrid, int32 InEndIndex, const Path::FHeuristic& InHeuristic);
+
+	/**
+	 * Runs Dijkstra from the goal until all the marked starts are settled. The parents then lead from each start to
+	 * the goal. The starts are reached even if occupied, but not passed through
+	 * @param InNumStarts The number of distinct points marked in BatchStarts
+	 */
+	void SearchReverse(const FGrid& InGrid, int32 InGoalIndex, int32 InNumStarts);
+
 	TUniquePtr<Path::FGraph> Graph;
+
+	// Reused by every FindPath call, so the queries don't allocate once the grid is known.
+	Path::FSearchScratch Scratch;
+
+	// The starts of the current batched query group
+	TBitArray<> BatchStarts;
+
+	// See GetNumExpanded
+	int32 NumExpanded = 0;
 };
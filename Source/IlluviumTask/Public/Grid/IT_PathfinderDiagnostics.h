@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IlluviumTask/IlluviumTask.h"
+
+/**
+ * Pathfinding trace points.
+ * They are compiled out of Shipping and Test builds, so the search loops carry no logging cost there.
+ * In other builds they are switched at runtime with the "it.Pathfinding.Trace" console variable
+ * and can be filtered further through the LogTaskPathfinding category.
+ */
+#ifndef IT_PATHFINDING_TRACE
+#define IT_PATHFINDING_TRACE !(UE_BUILD_SHIPPING || UE_BUILD_TEST)
+#endif
+
+#if IT_PATHFINDING_TRACE
+
+namespace Path::Diagnostics
+{
+	// Backs the "it.Pathfinding.Trace" console variable
+	extern ILLUVIUMTASK_API int32 GTraceEnabled;
+
+	FORCEINLINE bool IsTraceEnabled()
+	{
+		return GTraceEnabled != 0;
+	}
+}
+
+#define IT_PATH_TRACE_ENABLED() (Path::Diagnostics::IsTraceEnabled())
+
+// The arguments are only evaluated when tracing is enabled
+#define IT_PATH_TRACE(Format, ...) \
+	do \
+	{ \
+		if (IT_PATH_TRACE_ENABLED()) \
+		{ \
+			UE_LOG(LogTaskPathfinding, Display, Format, ##__VA_ARGS__); \
+		} \
+	} while (0)
+
+#else
+
+#define IT_PATH_TRACE_ENABLED() (false)
+#define IT_PATH_TRACE(Format, ...) do {} while (0)
+
+#endif
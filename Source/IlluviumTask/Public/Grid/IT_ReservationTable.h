@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Space-time reservations of the Grid points for a short window of turns ahead.
+ * The time is relative to the current turn: 0 is the turn being planned, the window is the last reservable turn.
+ * Only the reserved entries are stored, so the table costs as much as the units reserve, not the Grid size times
+ * the window.
+ */
+class ILLUVIUMTASK_API IT_ReservationTable
+{
+public:
+	/**
+	 * Init the table, all the points are free
+	 * @param InNumPoints The number of the Grid points
+	 * @param InWindow The number of turns ahead that can be reserved
+	 */
+	void Init(int32 InNumPoints, int32 InWindow);
+
+	/**
+	 * Frees all the points
+	 */
+	void Reset();
+
+	int32 GetWindow() const
+	{
+		return Window;
+	}
+
+	/**
+	 * @return Id of the unit that reserved the point at the time, INDEX_NONE if it is free
+	 */
+	int32 GetReservation(int32 InIndex, int32 InTime) const
+	{
+		const int32* Reservation = Reservations.Find(GetEntry(InIndex, InTime));
+		return Reservation != nullptr ? *Reservation : INDEX_NONE;
+	}
+
+	/**
+	 * @return true if the point is reserved by another unit at the time
+	 */
+	bool IsReservedByOther(int32 InIndex, int32 InTime, int32 InUnitId) const
+	{
+		const int32 Reservation = GetReservation(InIndex, InTime);
+		return Reservation != INDEX_NONE && Reservation != InUnitId;
+	}
+
+	/**
+	 * Reserves the point at the time, replacing any other reservation
+	 */
+	void Reserve(int32 InIndex, int32 InTime, int32 InUnitId);
+
+	/**
+	 * Reserves the point from the time to the end of the window
+	 */
+	void ReserveFrom(int32 InIndex, int32 InFromTime, int32 InUnitId);
+
+	SIZE_T GetAllocatedSize() const
+	{
+		return Reservations.GetAllocatedSize();
+	}
+
+private:
+	int64 GetEntry(int32 InIndex, int32 InTime) const
+	{
+		return StaticCast<int64>(InTime) * NumPoints + InIndex;
+	}
+
+	// Unit id by Time * NumPoints + Index, for the times 0 to Window
+	TMap<int64, int32> Reservations;
+	int32 NumPoints = 0;
+	int32 Window = 0;
+};
@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "StaticData.h"
+
+/**
+ * A per-team uniform bucket index over the grid cells.
+ * The grid is split into square buckets of BucketSize cells, every team keeps its units in those buckets.
+ * Closest opponent look-ups search the buckets in rings of growing size around the unit and stop
+ * as soon as no bucket further away can hold anything closer.
+ */
+class ILLUVIUMTASK_API IT_SpatialIndex
+{
+public:
+	/**
+	 * Init the index. Drops everything that was registered before
+	 * @param InGridSizeX Size of the X side of the Grid
+	 * @param InGridSizeY Size of the Y side of the Grid
+	 * @param InBucketSize Size of the bucket side in grid cells
+	 */
+	void Init(int32 InGridSizeX, int32 InGridSizeY, int32 InBucketSize);
+
+	void Add(int32 InUnitId, ETeam InTeam, const FIntPoint& InCoordinates);
+
+	void Remove(int32 InUnitId, ETeam InTeam, const FIntPoint& InCoordinates);
+
+	void Move(int32 InUnitId, ETeam InTeam, const FIntPoint& InFromCoordinates, const FIntPoint& InToCoordinates);
+
+	/**
+	 * Find the closest unit that is not a member of the team
+	 * @param InCoordinates Coordinates to search around
+	 * @param InTeam The team whose opponents are looked up
+	 * @param OutDistanceSqr Square distance to the found opponent
+	 * @return Id of the found opponent, INDEX_NONE if there are none
+	 */
+	int32 FindClosestOpponent(const FIntPoint& InCoordinates, ETeam InTeam, int32& OutDistanceSqr) const;
+
+	/**
+	 * @return The memory allocated for the buckets, in bytes
+	 */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	struct FEntry
+	{
+		int32 UnitId = INDEX_NONE;
+		// Kept next to the id, so the search doesn't touch the unit store
+		FIntPoint Coordinates;
+	};
+
+	using FBucket = TArray<FEntry>;
+
+	int32 GetBucketIndex(const FIntPoint& InCoordinates) const;
+
+	int32 BucketSize = 1;
+	int32 NumBucketsX = 0;
+	int32 NumBucketsY = 0;
+
+	TMap<ETeam, TArray<FBucket>> TeamBuckets;
+};
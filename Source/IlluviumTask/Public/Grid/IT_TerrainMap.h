@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "IT_TerrainMap.generated.h"
+
+/**
+ * The static terrain of a map: a cost per grid point, see FGrid::SetTerrain.
+ * Authored as a grayscale image, one pixel per point, where the pixel value is the cost: black (0) is a wall, 16 is
+ * the regular ground, 8 a road, 48 mud. The image is imported into the asset in the editor, so the game only loads
+ * a byte per point.
+ */
+UCLASS(BlueprintType)
+class ILLUVIUMTASK_API UIT_TerrainMap : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	/**
+	 * Decodes a grayscale image (any format the ImageWrapper module reads, e.g. PNG) into the terrain costs
+	 * @param InPath Path of the image file
+	 * @param OutSizeX The image width
+	 * @param OutSizeY The image height
+	 * @param OutCosts The cost of each point, row after row
+	 * @return false if the image could not be read
+	 */
+	static bool LoadImage(const FString& InPath, int32& OutSizeX, int32& OutSizeY, TArray<uint8>& OutCosts);
+
+	bool IsValid() const
+	{
+		return SizeX > 0 && SizeY > 0 && Costs.Num() == SizeX * SizeY;
+	}
+
+#if WITH_EDITOR
+	/**
+	 * Replaces the costs with the ones of the source image
+	 */
+	UFUNCTION(CallInEditor, Category="Terrain")
+	void ImportSourceImage();
+#endif
+
+#if WITH_EDITORONLY_DATA
+	UPROPERTY(EditAnywhere, Category="Terrain", meta=(FilePathFilter="png"))
+	FFilePath SourceImage;
+#endif
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Terrain")
+	int32 SizeX = 0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Terrain")
+	int32 SizeY = 0;
+
+	// The cost of each point, row after row
+	UPROPERTY()
+	TArray<uint8> Costs;
+};
@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Converts the variable frame time into a number of fixed simulation steps.
+ * The time left over after the steps is kept for the next frame, so the simulation rate doesn't depend on the frame rate.
+ * The number of catch-up steps per frame is capped, whole steps beyond the cap are dropped to keep a slow frame
+ * from spiralling into even slower ones.
+ */
+struct ILLUVIUMTASK_API FFixedStepScheduler
+{
+	/**
+	 * @param InStepSeconds Duration of a single simulation step
+	 * @param InMaxStepsPerFrame The maximum number of steps a single frame can run
+	 */
+	void Init(float InStepSeconds, int32 InMaxStepsPerFrame);
+
+	/**
+	 * Drops the accumulated time
+	 */
+	void Reset();
+
+	/**
+	 * Accumulates the frame time
+	 * @param InDeltaSeconds The frame time
+	 * @return The number of simulation steps to run this frame
+	 */
+	int32 Advance(float InDeltaSeconds);
+
+	/**
+	 * @return The accumulated part of the next step in the [0;1] range, for interpolating between the last two
+	 * simulation states
+	 */
+	float GetAlpha() const;
+
+	float GetStepSeconds() const
+	{
+		return StepSeconds;
+	}
+
+private:
+	double Accumulator = 0.0;
+	float StepSeconds = 0.1f;
+	int32 MaxStepsPerFrame = 1;
+};
@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * The subsystems drawing random numbers, each gets an independent stream.
+ * New streams are added at the end, so the existing ones keep their sequences for the same root seed.
+ */
+enum class ESimulationRandomStream : uint32
+{
+	SpawnPoints,
+	UnitStats,
+};
+
+/**
+ * A PCG32 (XSH RR) random number generator.
+ * Fast, small and of a good statistical quality. Every sequence number selects an independent stream, so the streams
+ * of the subsystems and the threads don't overlap.
+ * Not thread safe, every thread is expected to use its own stream.
+ */
+struct ILLUVIUMTASK_API FSimulationRandomStream
+{
+	FSimulationRandomStream()
+	{
+		Init(0, 0);
+	}
+
+	FSimulationRandomStream(uint64 InSeed, uint64 InSequence)
+	{
+		Init(InSeed, InSequence);
+	}
+
+	/**
+	 * @param InSeed The starting point of the stream
+	 * @param InSequence Selects the stream
+	 */
+	void Init(uint64 InSeed, uint64 InSequence);
+
+	/**
+	 * @return The next uniformly distributed 32 bits
+	 */
+	uint32 Next();
+
+	/**
+	 * @return A uniformly distributed integer in the [InMin;InMax] range, without the modulo bias
+	 */
+	int32 RandRange(int32 InMin, int32 InMax);
+
+	/**
+	 * @return A uniformly distributed float in the [0;1) range
+	 */
+	float GetFraction();
+
+	/**
+	 * @return A uniformly distributed float in the [InMin;InMax) range
+	 */
+	float FRandRange(float InMin, float InMax);
+
+private:
+	uint64 State = 0;
+	uint64 Increment = 1;
+};
+
+/**
+ * Derives the random streams of a simulation from a single root seed.
+ * The same root seed gives the same streams, so a battle can be replayed exactly, and the streams only depend on
+ * the subsystem and the sub-stream, not on the order they are made in.
+ */
+struct ILLUVIUMTASK_API FSimulationRandom
+{
+	void Init(int32 InRootSeed)
+	{
+		RootSeed = InRootSeed;
+	}
+
+	int32 GetRootSeed() const
+	{
+		return RootSeed;
+	}
+
+	/**
+	 * @param InStream The subsystem to make the stream for
+	 * @param InSubStream Separates the streams of a subsystem, e.g. one per worker thread
+	 * @return A new stream, at its start
+	 */
+	FSimulationRandomStream MakeStream(ESimulationRandomStream InStream, uint32 InSubStream = 0) const;
+
+private:
+	int32 RootSeed = 0;
+};
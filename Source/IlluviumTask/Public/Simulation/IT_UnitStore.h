@@ -0,0 +1,76 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "StaticData.h"
+
+/**
+ * The simulation state of all the units, stored as a struct of arrays.
+ * A unit is identified by its index in the arrays (the unit id). Killed units are only cleared from the alive mask,
+ * so the ids stay stable for the whole simulation.
+ */
+struct ILLUVIUMTASK_API FUnitStore
+{
+	/**
+	 * Add a unit to the store
+	 * @return The id of the added unit
+	 */
+	int32 AddUnit(ETeam InTeam, const FIntPoint& InPosition, float InHealth, float InAttackPower, int32 InAttackRange);
+
+	/**
+	 * Remove all the units
+	 */
+	void Reset();
+
+	/**
+	 * Reserve space for the given number of units
+	 */
+	void Reserve(int32 InNumUnits);
+
+	/**
+	 * @return The number of units ever added, including the killed ones
+	 */
+	int32 Num() const
+	{
+		return Positions.Num();
+	}
+
+	bool IsAlive(int32 InUnitId) const
+	{
+		return AliveMask[InUnitId];
+	}
+
+	void Kill(int32 InUnitId)
+	{
+		Health[InUnitId] = 0.f;
+		AliveMask[InUnitId] = false;
+	}
+
+	/**
+	 * Remember the current positions as the previous ones. Called at the start of every simulation step
+	 */
+	void SavePreviousPositions()
+	{
+		PreviousPositions = Positions;
+	}
+
+	/**
+	 * @return The memory allocated for the units, in bytes
+	 */
+	SIZE_T GetAllocatedSize() const
+	{
+		return Positions.GetAllocatedSize() + PreviousPositions.GetAllocatedSize() + Health.GetAllocatedSize()
+			+ AttackPower.GetAllocatedSize() + AttackRange.GetAllocatedSize() + Teams.GetAllocatedSize()
+			+ AliveMask.GetAllocatedSize();
+	}
+
+	TArray<FIntPoint> Positions;
+	// Positions at the start of the last simulation step, used to interpolate the visuals
+	TArray<FIntPoint> PreviousPositions;
+	TArray<float> Health;
+	TArray<float> AttackPower;
+	TArray<int32> AttackRange;
+	TArray<ETeam> Teams;
+	TBitArray<> AliveMask;
+};
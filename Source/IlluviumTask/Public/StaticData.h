@@ -10,6 +10,76 @@ enum class ETeam
 	MAX UMETA(DisplayName="MaxTeams")
 };
 
+/**
+ * Defines how the units pick their targets and next moves during a simulation turn
+ */
+UENUM()
+enum class EUnitNavigationMode
+{
+	// Every unit searches for its closest opponent and steps greedily towards it
+	Greedy UMETA(DisplayName="Greedy"),
+	// One flow field per team is built each turn, the units read their target and next move from it
+	FlowField UMETA(DisplayName="FlowField"),
+	// Every unit follows an obstacle-aware path to its closest opponent, cached and repaired across the turns
+	Pathfinding UMETA(DisplayName="Pathfinding"),
+	// The units plan their moves a few turns ahead one after another, reserving the points so they don't block each other
+	Cooperative UMETA(DisplayName="Cooperative")
+};
+
+/**
+ * Defines how the simulation units are visualized
+ */
+UENUM()
+enum class EUnitVisualizationMode
+{
+	// No visuals, the simulation only runs on the data
+	None UMETA(DisplayName="None"),
+	// An actor with its own mesh component per unit
+	Actors UMETA(DisplayName="Actors"),
+	// One instanced mesh per team, for large numbers of units
+	Instanced UMETA(DisplayName="Instanced")
+};
+
+/**
+ * Defines the topology of the grid, i.e. which points are connected
+ */
+UENUM()
+enum class EGridType
+{
+	None UMETA(DisplayName="None"),
+	// 4 connections per point
+	Rectangular UMETA(DisplayName="Rectangular"),
+	// 6 connections per point, the odd rows are shifted by half a point to the right
+	Hexagonal UMETA(DisplayName="Hexagonal"),
+	// 8 connections per point, the diagonal ones cost the square root of 2
+	Octagonal UMETA(DisplayName="Octagonal")
+};
+
+/**
+ * Defines the order the grid points are stored in, i.e. how the coordinates map to the point indices
+ */
+UENUM()
+enum class EGridCellOrdering
+{
+	// Row after row, the vertical neighbors are a whole row apart
+	RowMajor UMETA(DisplayName="Row Major"),
+	// 8x8 tiles row after row, the points of a tile in the Morton (Z) order. Neighbors mostly share a tile, so
+	// the searches touch fewer cache lines
+	Tiled UMETA(DisplayName="Tiled")
+};
+
+/**
+ * Defines the search algorithm of a path query
+ */
+UENUM()
+enum class EPathSearchMode
+{
+	// A* over every neighbor of the expanded points
+	AStar UMETA(DisplayName="AStar"),
+	// Jump point search, only expands the points where an optimal path may turn. Rectangular and octagonal grids only
+	JumpPoint UMETA(DisplayName="JumpPoint")
+};
+
 /**
  * Grid oriented coordinates
  */